@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  FreqCounter.c - Frequency counter on a spare PIO SM gated by GPS PPS.
+//
+//  DESCRIPTION
+//      The edges of a GPIO are counted by PIO and latched at each GPS PPS,
+//  see fcount.pio. The freq is the least squares slope of the counts of
+//  a gate of several seconds, so the +/-1 edge quantization of each latch
+//  is averaged down, which yields millihertz on the longer gates.
+//      The counted GPIO and PPS are only read, so it can count the RF output
+//  of DCO which is driven by the other PIO.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "FreqCounter.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "../pico-hf-oscillator/lib/assert.h"
+
+#include "build/fcount.pio.h"
+
+static int si_fcount_offset = -1;
+
+/// @brief Initializes the counter on pio1, the DCO uses pio0.
+/// @param pfc Ptr to counter context.
+/// @param gpio The GPIO to count.
+/// @param pps_gpio The GPIO of GPS PPS.
+/// @return 0 if OK. -1 no free SM.
+int FreqCounterInit(FreqCounterContext *pfc, int gpio, int pps_gpio)
+{
+    assert_(pfc);
+
+    memset(pfc, 0, sizeof(FreqCounterContext));
+
+    pfc->_pio = pio1;
+    pfc->_gpio = gpio;
+    pfc->_pps_gpio = pps_gpio;
+    pfc->_ism = pio_claim_unused_sm(pfc->_pio, false);
+    if(pfc->_ism < 0)
+    {
+        return -1;
+    }
+
+    if(si_fcount_offset < 0)
+    {
+        si_fcount_offset = pio_add_program(pfc->_pio, &fcount_program);
+    }
+    pfc->_offset = si_fcount_offset;
+
+    fcount_program_init(pfc->_pio, pfc->_ism, pfc->_offset, gpio, pps_gpio);
+
+    return 0;
+}
+
+/// @brief Stops the counter and frees its SM. The u-program stays loaded.
+/// @param pfc Ptr to counter context.
+void FreqCounterDeinit(FreqCounterContext *pfc)
+{
+    assert_(pfc);
+
+    pio_sm_set_enabled(pfc->_pio, pfc->_ism, false);
+    pio_sm_unclaim(pfc->_pio, pfc->_ism);
+}
+
+/// @brief Waits for the count latched at the next PPS.
+/// @param pfc Ptr to counter context.
+/// @param pu32count Ptr to the count.
+/// @return 0 if OK. -1 no PPS in time.
+static int FreqCounterGetLatch(FreqCounterContext *pfc, uint32_t *pu32count)
+{
+    const uint64_t u64tmend = time_us_64() + FREQCOUNTER_PPS_TIMEOUT_US;
+    while(pio_sm_is_rx_fifo_empty(pfc->_pio, pfc->_ism))
+    {
+        if(time_us_64() > u64tmend)
+        {
+            return -1;
+        }
+        tight_loop_contents();
+    }
+    *pu32count = pio_sm_get(pfc->_pio, pfc->_ism);
+
+    return 0;
+}
+
+/// @brief Measures the freq of GPIO over a gate of whole PPS seconds.
+/// @param pfc Ptr to counter context.
+/// @param gate_s The gate, 1..FREQCOUNTER_MAX_GATE_S seconds.
+/// @param pi64_millihz Ptr to the freq measured, mHz.
+/// @return 0 if OK. -1 no PPS. -2 invalid gate.
+/// @remark It blocks for the gate plus up to 2 seconds. The first latch is
+/// @remark dropped since SM might start while PPS is high.
+/// @remark The slope of G+1 counts has the error of a single count over G
+/// @remark divided by ~sqrt(G/6), e.g. ~20 mHz rms at 10 s and ~1 mHz at 60 s.
+int FreqCounterMeasure(FreqCounterContext *pfc, int gate_s, int64_t *pi64_millihz)
+{
+    assert_(pfc);
+    assert_(pi64_millihz);
+
+    if(gate_s < 1 || gate_s > FREQCOUNTER_MAX_GATE_S)
+    {
+        return -2;
+    }
+
+    pio_sm_set_enabled(pfc->_pio, pfc->_ism, false);
+    pio_sm_clear_fifos(pfc->_pio, pfc->_ism);
+    pio_sm_restart(pfc->_pio, pfc->_ism);
+    pio_sm_exec(pfc->_pio, pfc->_ism, pio_encode_jmp(pfc->_offset));
+    pio_sm_set_enabled(pfc->_pio, pfc->_ism, true);
+
+    uint32_t u32prev;
+    if(FreqCounterGetLatch(pfc, &u32prev) || FreqCounterGetLatch(pfc, &u32prev))
+    {
+        pio_sm_set_enabled(pfc->_pio, pfc->_ism, false);
+        return -1;
+    }
+
+    /* Least squares slope of counts N_k vs k = 0..G, using d_k = 2k - G so
+       it is integer: f = 2 * sum(d_k * N_k) / sum(d_k^2). */
+    int64_t i64edges = 0, i64sum_dn = 0, i64sum_dd = (int64_t)gate_s * gate_s;
+    for(int k = 1; k <= gate_s; ++k)
+    {
+        uint32_t u32count;
+        if(FreqCounterGetLatch(pfc, &u32count))
+        {
+            pio_sm_set_enabled(pfc->_pio, pfc->_ism, false);
+            return -1;
+        }
+        i64edges += (uint32_t)(u32prev - u32count);   /* X counts down. */
+        u32prev = u32count;
+
+        const int64_t i64d = 2 * k - gate_s;
+        i64sum_dn += i64d * i64edges;
+        i64sum_dd += i64d * i64d;
+    }
+    pio_sm_set_enabled(pfc->_pio, pfc->_ism, false);
+
+    *pi64_millihz = (2000LL * i64sum_dn + i64sum_dd / 2) / i64sum_dd;
+
+    return 0;
+}
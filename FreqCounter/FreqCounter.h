@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  FreqCounter.h - Frequency counter on a spare PIO SM gated by GPS PPS.
+//
+//  DESCRIPTION
+//      The interface of the counter, see FreqCounter.c.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef FREQCOUNTER_H_
+#define FREQCOUNTER_H_
+
+#include <stdint.h>
+#include "hardware/pio.h"
+
+#define FREQCOUNTER_MAX_GATE_S 60   /* The longest gate, s. */
+#define FREQCOUNTER_PPS_TIMEOUT_US 1500000ULL   /* Max PPS period, us. */
+
+typedef struct
+{
+    PIO _pio;                   /* PIO of the counter. */
+    int _ism;                   /* Index of state machine. */
+    int _offset;                /* fcount u-program offset. */
+    int _gpio;                  /* The GPIO counted. */
+    int _pps_gpio;              /* The GPS PPS GPIO gating the count. */
+} FreqCounterContext;
+
+int FreqCounterInit(FreqCounterContext *pfc, int gpio, int pps_gpio);
+void FreqCounterDeinit(FreqCounterContext *pfc);
+int FreqCounterMeasure(FreqCounterContext *pfc, int gate_s, int64_t *pi64_millihz);
+
+#endif
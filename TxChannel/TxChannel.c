@@ -69,20 +69,36 @@ static int64_t __not_in_flash_func (TxChannelISR)(alarm_id_t id, void *user_data
 {
     PioDco *pDCO = txChannelContext._p_oscillator;
 
-    uint8_t byte;
-    const int n2send = TxChannelPop(&byte);
+    TxChannelSymbol sym;
+    const int n2send = TxChannelPop(&sym);
     if(n2send)
     {
-        const int32_t i32_compensation_millis = 
-            PioDCOGetFreqShiftMilliHertz(txChannelContext._p_oscillator, 
-                                         (uint64_t)(txChannelContext._u32_Txfreqhz * 1000LL));
+        if(TXCHANNEL_KEY_UP == sym._u8_tone)
+        {
+            PioDCOKeyUp(pDCO);
+            txChannelContext._u8_key_up = YES;
+        }
+        else
+        {
+            if(txChannelContext._u8_key_up)
+            {
+                PioDCOKeyDown(pDCO);
+                txChannelContext._u8_key_up = NO;
+            }
 
-        PioDCOSetFreq(pDCO, txChannelContext._u32_Txfreqhz, 
-                      (uint32_t)byte * WSPR_FREQ_STEP_MILHZ - 2 * i32_compensation_millis);
+            if(eDCOENGINE_PATTERN == pDCO->_engine || eDCOENGINE_BITSTREAM == pDCO->_engine)
+            {
+                PioDCOPatternSelect(pDCO, sym._u8_tone);
+            }
+            else
+            {
+                PioDCOToneSelect(pDCO, txChannelContext._p_tones, sym._u8_tone);
+            }
+        }
 
 
 #ifdef BARE_METAL_TIMER
-        txChannelContext._tm_future_call += txChannelContext._bit_period_us;
+        txChannelContext._tm_future_call += sym._u32_duration_us;
         hw_clear_bits(&timer_hw->intr, 1U<<txChannelContext._timer_alarm_num);
         timer_hw->alarm[txChannelContext._timer_alarm_num] = (uint32_t)txChannelContext._tm_future_call;
 #endif        
@@ -95,12 +111,12 @@ static int64_t __not_in_flash_func (TxChannelISR)(alarm_id_t id, void *user_data
 #endif
     }
 #ifndef BARE_METAL_TIMER
-    return txChannelContext._bit_period_us;// next period duration
+    return sym._u32_duration_us;// next period duration, from the time this one was due
 #endif 
 }
 
 /// @brief Initializes a TxChannel context. Starts ISR.
-/// @param bit_period_us Period of data bits, BPS speed = 1e6/bit_period_us.
+/// @param bit_period_us Duration of the symbols pushed by TxChannelPush, us.
 /// @param timer_alarm_num Pico-specific hardware timer resource id.
 /// @param pDCO Ptr to oscillator.
 /// @return the Context.
@@ -142,8 +158,172 @@ void TxChannelSetOffsetFrequency(uint32_t offsetFreq)
     PioDCOSetFreq(txChannelContext._p_oscillator, txChannelContext._u32_Txfreqhz, 0);// Reset the freq.
 }
 
+/// @brief Calculates the worst error of tone spacing the patterns of a carrier
+/// @brief would have. The common error only shifts the signal, whereas that of
+/// @brief spacing makes the symbols land between the bins of decoder.
+/// @param ui32_frq_hz The carrier [Hz].
+/// @param i32_compensation_millis The freq. correction [mHz].
+/// @return The worst spacing error [mHz].
+static int32_t TxChannelPatternSpacingError(uint32_t ui32_frq_hz, int32_t i32_compensation_millis)
+{
+    const PioDco *pDCO = txChannelContext._p_oscillator;
+
+    const int32_t i32err0 = PioDCOPatternError(pDCO, ui32_frq_hz, -2 * i32_compensation_millis);
+    int32_t i32worst = 0;
+    for(int i = 1; i < PIODCO_PATTERN_TONES; ++i)
+    {
+        int32_t i32err = PioDCOPatternError(pDCO, ui32_frq_hz, i * WSPR_FREQ_STEP_MILHZ - 2 * i32_compensation_millis)
+                         - i32err0;
+        if(i32err < 0)
+        {
+            i32err = -i32err;
+        }
+        if(i32err > i32worst)
+        {
+            i32worst = i32err;
+        }
+    }
+
+    return i32worst;
+}
+
+/// @brief Builds tone patterns of the DCO pattern engine for the transmission.
+/// @remark The error of a pattern jumps around with the freq, since it is
+/// @remark that of the best rational of q <= PIODCO_PATTERN_MAX_WORDS. The
+/// @remark carrier is shifted by the first whole Hz within the WSPR range
+/// @remark the spacing error fits at, or by the best one if none fits.
+static void TxChannelBuildTonePatterns(void)
+{
+    PioDco *pDCO = txChannelContext._p_oscillator;
+
+    const int32_t i32_compensation_millis = 
+        PioDCOGetFreqShiftMilliHertz(pDCO, (uint64_t)(txChannelContext._u32_Txfreqhz * 1000LL));
+
+    /* The 6 Hz of modulation stays within the range. */
+    const int32_t i32lo = (int32_t)(txChannelContext._u32_dialfreqhz - txChannelContext._u32_Txfreqhz);
+    const int32_t i32hi = i32lo + WSPR_FREQ_RANGE_HZ - 6;
+    int32_t i32best_shift = 0;
+    int32_t i32best_err = INT32_MAX;
+    for(int k = 0; k <= 2 * WSPR_FREQ_RANGE_HZ; ++k)
+    {
+        const int32_t i32shift = (k & 1) ? (k + 1) / 2 : -(k / 2);
+        if(i32shift < i32lo || i32shift > i32hi)
+        {
+            continue;
+        }
+        const int32_t i32err = TxChannelPatternSpacingError(txChannelContext._u32_Txfreqhz + i32shift,
+                                                            i32_compensation_millis);
+        if(i32err < i32best_err)
+        {
+            i32best_err = i32err;
+            i32best_shift = i32shift;
+        }
+        if(i32err <= TXCHANNEL_PATTERN_MAX_ERR_MILLIHZ)
+        {
+            break;
+        }
+    }
+    txChannelContext._i32_pattern_shift_hz = i32best_shift;
+    txChannelContext._i32_pattern_err_millihz = i32best_err;
+
+    for(int i = 0; i < PIODCO_PATTERN_TONES; ++i)
+    {
+        PioDCOPatternBuild(pDCO, i, txChannelContext._u32_Txfreqhz + i32best_shift, 
+                           i * WSPR_FREQ_STEP_MILHZ - 2 * i32_compensation_millis);
+    }
+}
+
+/// @brief Builds the tone table of the transmission into the table ISR doesn't
+/// @brief use, then switches ISR to it.
+static void TxChannelBuildToneTable(void)
+{
+    PioDcoToneTable *ptt = &txChannelContext._tones[txChannelContext._p_tones == &txChannelContext._tones[0]];
+
+    PioDCOToneTableBuild(txChannelContext._p_oscillator, ptt, txChannelContext._u32_Txfreqhz,
+                         WSPR_FREQ_STEP_MILHZ);
+    txChannelContext._p_tones = ptt;
+}
+
+/// @brief Rebuilds the tone table if GPS correction has changed. It is to be
+/// @brief called from the thread code every second or so.
+void TxChannelRefreshTones(void)
+{
+    if(txChannelContext._p_tones
+       && PioDCOToneTableIsStale(txChannelContext._p_oscillator, txChannelContext._p_tones))
+    {
+        TxChannelBuildToneTable();
+    }
+}
+
+/// @brief Queues the whole transmission to the DCO worker with the time of
+/// @brief each symbol, so the symbol edges are made by core1. The freq
+/// @brief correction is taken once at the start of the transmission.
+/// @remark The timed queue has no key up, so the keyed timelines are sent by ISR.
+/// @remark The symbols the timed queue has no room for stay in the channel.
+/// @return The time the queued part ends at, us.
+static uint64_t TxChannelQueueTransmission(void)
+{
+    PioDco *pDCO = txChannelContext._p_oscillator;
+
+    PioDCOTimedFlush(pDCO);
+    PioDCOTimedClearHistogram(pDCO);
+
+    const int32_t i32_compensation_millis = 
+        PioDCOGetFreqShiftMilliHertz(pDCO, (uint64_t)(txChannelContext._u32_Txfreqhz * 1000LL));
+
+    /* Time ahead enough to queue it all, so the first edge is on time too. */
+    uint64_t u64tm = time_us_64() + 10000ULL;
+    const TxChannelSymbol *psym;
+    while(NULL != (psym = TxChannelRingPeek(&txChannelContext._ring)))
+    {
+        if(PioDCOTimedPush(pDCO, u64tm, txChannelContext._u32_Txfreqhz, 
+                           (uint32_t)psym->_u8_tone * WSPR_FREQ_STEP_MILHZ - 2 * i32_compensation_millis))
+        {
+            break;
+        }
+        u64tm += psym->_u32_duration_us;
+        TxChannelRingDrop(&txChannelContext._ring);
+    }
+
+    return u64tm;
+}
+
 void TxChannelStart(void)
 {    
+    PioDco *pDCO = txChannelContext._p_oscillator;
+
+    PioDCOFifoStatsStart(pDCO);
+    txChannelContext._u8_key_up = pDCO->_u8_key_up || pDCO->_env_alarm > 0;
+    txChannelContext._u8_running = YES;
+
+    if(eDCOENGINE_PATTERN == txChannelContext._p_oscillator->_engine
+       || eDCOENGINE_BITSTREAM == txChannelContext._p_oscillator->_engine)
+    {
+        TxChannelBuildTonePatterns();
+    }
+    TxChannelBuildToneTable();// TxChannelStop goes back to its tone 0 in any engine.
+
+#ifndef BARE_METAL_TIMER
+    if(eDCOENGINE_TIMED == txChannelContext._p_oscillator->_engine && !txChannelContext._u8_keying)
+    {
+        /* The carrier is on the 1st tone until the 1st edge. */
+        const TxChannelSymbol *pfirst = TxChannelRingPeek(&txChannelContext._ring);
+        if(pfirst)
+        {
+            PioDCOToneSelect(pDCO, txChannelContext._p_tones, pfirst->_u8_tone);
+        }
+
+        const uint64_t u64tmend = TxChannelQueueTransmission();
+        PioDCOStart(txChannelContext._p_oscillator);
+
+        /* ISR sends the rest if any, and stops when there is none. */
+        txChannelContext.alarmId = alarm_pool_add_alarm_at(txChannelContext.alarmPool, 
+                                                           from_us_since_boot(u64tmend),
+                                                           TxChannelISR, NULL, true);
+        return;
+    }
+#endif
+
 
     PioDCOStart(txChannelContext._p_oscillator);// turn on the oscillator
 #ifdef BARE_METAL_TIMER
@@ -152,8 +332,13 @@ void TxChannelStart(void)
     timer_hw->alarm[txChannelContext._timer_alarm_num] = (uint32_t)txChannelContext._tm_future_call;
     TxChannelISR();
 #else
-	txChannelContext.alarmId = alarm_pool_add_alarm_in_us( txChannelContext.alarmPool, txChannelContext._bit_period_us, TxChannelISR, NULL, true );
-    TxChannelISR(txChannelContext.alarmId, NULL);
+    /* The 1st symbol is sent now, the alarm is due when it ends. */
+    const int64_t i64_first_us = TxChannelISR(0, NULL);
+    if(i64_first_us > 0)
+    {
+        txChannelContext.alarmId = alarm_pool_add_alarm_in_us(txChannelContext.alarmPool, i64_first_us,
+                                                              TxChannelISR, NULL, true);
+    }
 #endif
 
 
@@ -170,53 +355,88 @@ void TxChannelStop(void)
 #else
     alarm_pool_cancel_alarm(txChannelContext.alarmPool, txChannelContext.alarmId);
 #endif    
-    PioDCOSetFreq(txChannelContext._p_oscillator, txChannelContext._u32_Txfreqhz, 0);// Reset the freq.
+    if(txChannelContext._p_tones)// None before the 1st start.
+    {
+        PioDCOToneSelect(txChannelContext._p_oscillator, txChannelContext._p_tones, 0);// Reset the freq, no divisions in ISR.
+    }
     gpio_put(PICO_DEFAULT_LED_PIN, 0); // Turn off the LED
+    txChannelContext._u8_running = NO;
+}
+
+/// @brief Tells whether the channel is sending, i.e. the last symbol hasn't
+/// @brief ended yet.
+/// @return YES if running, NO otherwise.
+int TxChannelIsRunning(void)
+{
+    return txChannelContext._u8_running;
 }
 
 /// @brief Gets a count of bytes to send.
-/// @param pctx Context.
 /// @return A count of bytes.
-uint8_t TxChannelPending(void)
+int TxChannelPending(void)
 {
-    return 256L + (int)txChannelContext._ix_input - (int)txChannelContext._ix_output;
+    return (int)TxChannelRingCount(&txChannelContext._ring);
 }
 
-/// @brief Push a number of bytes to the output FIFO.
-/// @param pctx Context.
+/// @brief Push a number of bytes to the output FIFO, each one is a tone which
+/// @brief lasts the bit period of TxChannelInit.
 /// @param psrc Ptr to buffer to send.
 /// @param n A count of bytes to send.
 /// @return A count of bytes has been sent (might be lower than n).
-int TxChannelPush(uint8_t *psrc, int n)
+int TxChannelPush(const uint8_t *psrc, int n)
 {
-    uint8_t *pdst = txChannelContext._pbyte_buffer;
-    while(n-- && txChannelContext._ix_input != txChannelContext._ix_output)
+    TxChannelSymbol sym = { 0, txChannelContext._bit_period_us };
+    int i = 0;
+    for(; i < n; ++i)
     {
-        pdst[txChannelContext._ix_input++] = *psrc++;
+        sym._u8_tone = psrc[i];
+        if(!TxChannelRingPush(&txChannelContext._ring, &sym))
+        {
+            break;
+        }
     }
 
-    return n;
+    return i;
 }
 
-/// @brief Retrieves a next byte from FIFO.
-/// @param pctx Context.
-/// @param pdst Ptr to write a byte.
-/// @return 1 if a byte has been retrived, or 0.
-int TxChannelPop(uint8_t *pdst)
+/// @brief Push a number of symbols of their own durations to the output FIFO.
+/// @param psrc Ptr to the symbols to send.
+/// @param n A count of symbols to send.
+/// @return A count of symbols has been sent (might be lower than n).
+/// @remark It might be called while the channel is running, to feed timelines
+/// @remark longer than the FIFO.
+int TxChannelPushSymbols(const TxChannelSymbol *psrc, int n)
 {
-    if(txChannelContext._ix_input != txChannelContext._ix_output)
+    int i = 0;
+    for(; i < n; ++i)
     {
-        *pdst = txChannelContext._pbyte_buffer[txChannelContext._ix_output++];
-
-        return 1;
+        assert_(psrc[i]._u32_duration_us > 10);
+        if(TXCHANNEL_KEY_UP == psrc[i]._u8_tone)
+        {
+            txChannelContext._u8_keying = YES;
+        }
+        if(!TxChannelRingPush(&txChannelContext._ring, &psrc[i]))
+        {
+            break;
+        }
     }
 
-    return 0;
+    return i;
+}
+
+/// @brief Retrieves a next symbol from FIFO.
+/// @param pdst Ptr to write a symbol.
+/// @return 1 if a symbol has been retrived, or 0.
+/// @remark It is called by ISR, or by the thread while ISR isn't running.
+int TxChannelPop(TxChannelSymbol *pdst)
+{
+    return TxChannelRingPop(&txChannelContext._ring, pdst);
 }
 
-/// @brief Clears FIFO completely. Sets write&read indexes to 0.
+/// @brief Clears FIFO completely. ISR mustn't be running.
 /// @param pctx Context.
 void TxChannelClear(TxChannelContext *pctx)
 {
-    txChannelContext._ix_input = txChannelContext._ix_output = 0;
+    TxChannelRingClear(&txChannelContext._ring);
+    txChannelContext._u8_keying = NO;
 }
@@ -55,25 +55,48 @@
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
 #include "../pico-hf-oscillator/lib/assert.h"
+#include "../pico-hf-oscillator/lib/spscring.h"
 #include <piodco.h>
 
 // Signals are always within a 200Hz frequench range , but modulation is 6Hz wide and allow for inaccurate crystals on the Pico
 #define WSPR_FREQ_RANGE_HZ  200
 
+#define TXCHANNEL_RING_LEN  256     /* Symbols, power of 2. */
+#define TXCHANNEL_KEY_UP    0xFF    /* The tone of a symbol with no carrier. */
+
+/* The tone patterns are shifted within the WSPR range, so that their spacing
+   error fits 1/8 of the WSPR tone spacing. */
+#define TXCHANNEL_PATTERN_MAX_ERR_MILLIHZ   183
+
+/* An entry of the timeline: a tone and how long it lasts. */
+typedef struct
+{
+    uint8_t _u8_tone;               /* Tone index, or TXCHANNEL_KEY_UP. */
+    uint32_t _u32_duration_us;      /* Time to the next symbol, us. */
+} TxChannelSymbol;
+
+SPSC_RING_DEFINE(TxChannelRing, TxChannelSymbol, TXCHANNEL_RING_LEN)
+
 typedef struct
 {
     uint64_t _tm_future_call;
-    uint32_t _bit_period_us;
+    uint32_t _bit_period_us;                /* Duration of symbols of TxChannelPush. */
 
     uint8_t _timer_alarm_num;
 
-    uint8_t _ix_input, _ix_output;
-    uint8_t _pbyte_buffer[256];
+    TxChannelRing _ring;                    /* Symbols to send, thread to ISR. */
+    uint8_t _u8_keying;                     /* The timeline has key up symbols. */
+    uint8_t _u8_key_up;                     /* The carrier is keyed up by ISR. */
+    volatile uint8_t _u8_running;           /* Started and not stopped yet. */
 
     PioDco *_p_oscillator;
+    PioDcoToneTable _tones[2];              /* Tones of TX, one ISR uses. */
+    PioDcoToneTable * volatile _p_tones;    /* The one ISR uses. */
     uint32_t _u32_Txfreqhz;    
     uint32_t _u32_dialfreqhz;
     uint32_t _u32_offsetfreqhz;
+    int32_t _i32_pattern_shift_hz;          /* Shift of the tone patterns, Hz. */
+    int32_t _i32_pattern_err_millihz;       /* Worst spacing error of them. */
 
     int _i_tx_gpio;
     alarm_pool_t *alarmPool;
@@ -82,15 +105,18 @@ typedef struct
 } TxChannelContext;
 
 TxChannelContext *TxChannelInit(const uint32_t bit_period_us, uint8_t timer_alarm_num);
-uint8_t TxChannelPending(void);
-int TxChannelPush(uint8_t *psrc, int n);
-int TxChannelPop(uint8_t *pdst);
+int TxChannelPending(void);
+int TxChannelPush(const uint8_t *psrc, int n);
+int TxChannelPushSymbols(const TxChannelSymbol *psrc, int n);
+int TxChannelPop(TxChannelSymbol *pdst);
 void TxChannelClear(TxChannelContext *pctx);
 
 void TxChannelStart(void);
 void TxChannelStop(void);
+int TxChannelIsRunning(void);
 void TxChannelSetFrequency(uint32_t dialFreq, uint32_t offsetFreq);
 void TxChannelSetOffsetFrequency(uint32_t offsetFreq);
+void TxChannelRefreshTones(void);
 
 
 #endif
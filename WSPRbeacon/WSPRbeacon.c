@@ -142,14 +142,40 @@ int WSPRbeaconSendPacket(void)
 
     TxChannelClear(becaconData._pTX);
 
-    memcpy(becaconData._pTX->_pbyte_buffer, becaconData._pu8_outbuf, WSPR_SYMBOL_COUNT);
-    becaconData._pTX->_ix_input = WSPR_SYMBOL_COUNT;
+    if(TxChannelPush(becaconData._pu8_outbuf, WSPR_SYMBOL_COUNT) != WSPR_SYMBOL_COUNT)
+    {
+        return -1;
+    }
 
     TxChannelStart();
 
     return 0;
 }
 
+/// @brief Gets the current second of hour of the schedule.
+/// @return The second of hour.
+static uint32_t WSPRbeaconSecOfHour(void)
+{
+    if( becaconData._txSched._u8_tx_GPS_mandatory)
+    {
+        // PPS occurs at the start of the second before the RMC message is received, hence the actual time at PPS is + 1 second from the last nmea time
+        return (becaconData._pTX->_p_oscillator->_pGPStime->_time_data._u32_utime_nmea_last + 1) % HOUR;
+    }
+
+    return becaconData.secondsCounter % HOUR;       
+}
+
+/// @brief Gets the index of slot modulo skip, 0 is the TX slot.
+/// @param isec_of_hour The second of hour.
+/// @return The slot index modulo skip.
+/// @remark The slots are counted from the start of hour, so unless the skip
+/// @remark divides 30 the TX slots don't recur evenly over the hour boundary.
+static uint32_t WSPRbeaconSlotModulo(uint32_t isec_of_hour)
+{
+    const uint32_t islot_number = (isec_of_hour  / (2 * MINUTE)) + becaconData.initialSlotOffset;
+    return islot_number % becaconData._txSched._u8_tx_slot_skip;
+}
+
 /// @brief Arranges WSPR sending in accordance with pre-defined schedule.
 /// @brief It works only if GPS receiver available (for now).
 /// @param pctx Ptr to Context.
@@ -166,24 +192,9 @@ int WSPRbeaconTxScheduler(int verbose)
 {
     bool debugPrint = verbose;
 
-    uint32_t isec_of_hour;
-    uint32_t islot_number;
-    uint32_t islot_modulo;
-
-    if( becaconData._txSched._u8_tx_GPS_mandatory)
-    {
-        // PPS occurs at the start of the second before the RMC message is received, hence the actual time at PPS is + 1 second from the last nmea time
-        isec_of_hour = (becaconData._pTX->_p_oscillator->_pGPStime->_time_data._u32_utime_nmea_last + 1) % HOUR;
-    }
-    else
-    {
-        isec_of_hour = becaconData.secondsCounter % HOUR;       
-    }
-
-    islot_number = (isec_of_hour  / (2 * MINUTE)) + becaconData.initialSlotOffset;
-    islot_modulo = islot_number % becaconData._txSched._u8_tx_slot_skip;
-
-    uint32_t secsIntoCurrentSlot = (isec_of_hour % (2 * MINUTE));
+    const uint32_t isec_of_hour = WSPRbeaconSecOfHour();
+    const uint32_t islot_modulo = WSPRbeaconSlotModulo(isec_of_hour);
+    const uint32_t secsIntoCurrentSlot = (isec_of_hour % (2 * MINUTE));
     
     if (debugPrint)
     {
@@ -202,11 +213,22 @@ int WSPRbeaconTxScheduler(int verbose)
             
                 printf("WSPR> Start TX.\n");    
 
+                const PioDco *pDCO = becaconData._pTX->_p_oscillator;
+                if (eDCOENGINE_PATTERN == pDCO->_engine || eDCOENGINE_BITSTREAM == pDCO->_engine)
+                {
+                    printf("WSPR> Tone patterns shifted %ld Hz, spacing error %ld mHz%s\n",
+                           becaconData._pTX->_i32_pattern_shift_hz, becaconData._pTX->_i32_pattern_err_millihz,
+                           becaconData._pTX->_i32_pattern_err_millihz > TXCHANNEL_PATTERN_MAX_ERR_MILLIHZ
+                           ? ", WARNING: too coarse to decode, use another engine" : "");
+                }
+
                 ledFlashTimer.delay_us = 500000;
             }
         }
         else
         {
+            TxChannelRefreshTones();
+
             // Check if Tx has finished and Osc has been turned off
             if (!becaconData._pTX->_p_oscillator->_is_enabled)
             {
@@ -214,6 +236,18 @@ int WSPRbeaconTxScheduler(int verbose)
  
                 printf("WSPR> End Tx. @ %d secs\n",secsIntoCurrentSlot);
 
+                PioDco *pDCO = becaconData._pTX->_p_oscillator;
+                printf("WSPR> DCO FIFO underruns:%lu overruns:%lu min level:%u\n",
+                       pDCO->_u32_fifo_stalls - pDCO->_u32_fifo_stalls_tx0,
+                       pDCO->_u32_fifo_overs - pDCO->_u32_fifo_overs_tx0, pDCO->_u8_fifo_min_level);
+                if (eDCOENGINE_TIMED == pDCO->_engine)
+                {
+                    printf("WSPR> Symbol edges late, us: 0:%lu 1:%lu 2-3:%lu 4-7:%lu 8-15:%lu 16-31:%lu 32-63:%lu 64+:%lu max:%lu\n",
+                           pDCO->_u32_edge_hist[0], pDCO->_u32_edge_hist[1], pDCO->_u32_edge_hist[2],
+                           pDCO->_u32_edge_hist[3], pDCO->_u32_edge_hist[4], pDCO->_u32_edge_hist[5],
+                           pDCO->_u32_edge_hist[6], pDCO->_u32_edge_hist[7], pDCO->_u32_edge_late_max_us);
+                }
+
                 if (settingsData.frequencyHop)
                 {
                     // Set the freq of the next transmission now.
@@ -244,6 +278,33 @@ int WSPRbeaconTxScheduler(int verbose)
     return 0;
 }
 
+/// @brief Calculates the time left to the start of next transmission. It is
+/// @brief for the low power mode, which the beacon is in before it.
+/// @return The seconds to the start of TX, 0 while transmitting.
+int WSPRbeaconSecondsToTx(void)
+{
+    if(itx_trigger)
+    {
+        return 0;
+    }
+
+    const uint32_t isec_of_hour = WSPRbeaconSecOfHour();
+    const uint32_t secsIntoCurrentSlot = (isec_of_hour % (2 * MINUTE));
+    const uint32_t isec_of_slot = isec_of_hour - secsIntoCurrentSlot;
+
+    /* TX starts at the second 1 of slot 0. The slots are stepped through
+       since their count restarts each hour. */
+    for(int islot = secsIntoCurrentSlot > 1; islot <= HOUR / (2 * MINUTE); ++islot)
+    {
+        if(0 == WSPRbeaconSlotModulo((isec_of_slot + islot * 2 * MINUTE) % HOUR))
+        {
+            return islot * 2 * MINUTE + 1 - secsIntoCurrentSlot;
+        }
+    }
+
+    return HOUR;
+}
+
 /// @brief Dumps the beacon context to stdio.
 /// @param pctx Ptr to Context.
 void WSPRbeaconDumpContext(void)
@@ -257,10 +318,41 @@ void WSPRbeaconDumpContext(void)
     StampPrintf("__________________");
     StampPrintf("=TxChannelContext=");
     StampPrintf("ftc:%llu", becaconData._pTX->_tm_future_call);
-    StampPrintf("ixi:%u", becaconData._pTX->_ix_input);
+    StampPrintf("pnd:%d", TxChannelPending());
     StampPrintf("dfq:%lu", becaconData._pTX->_u32_Txfreqhz);
     StampPrintf("gpo:%u", becaconData._pTX->_i_tx_gpio);
 
+    PioDco *pDCO = becaconData._pTX->_p_oscillator;
+    StampPrintf("=PioDco handoff=");
+    StampPrintf("seq:%lu/%lu", pDCO->_u32_applied_seq, pDCO->_u32_freq_seq);
+    StampPrintf("wix:%lu", pDCO->_u32_applied_word);
+    StampPrintf("lat:%lu us", pDCO->_u32_applied_us - pDCO->_u32_published_us);
+    StampPrintf("=PioDco FIFO=");
+    StampPrintf("stl:%lu/%lu", pDCO->_u32_fifo_stalls - pDCO->_u32_fifo_stalls_tx0, pDCO->_u32_fifo_stalls);
+    StampPrintf("ovr:%lu/%lu", pDCO->_u32_fifo_overs - pDCO->_u32_fifo_overs_tx0, pDCO->_u32_fifo_overs);
+    StampPrintf("min:%u/%u", pDCO->_u8_fifo_min_level, pDCO->_u8_fifo_min_ever);
+    if(pDCO->_u8_group_n)
+    {
+        StampPrintf("=PioDco phases=");
+        for(int i = 1; i < pDCO->_u8_group_n; ++i)
+        {
+            const PioDco *pph = pDCO->_apgroup[i];
+            StampPrintf("p%d:%d/%ld mc %lu c", i, pph->_i16_phase_offset, PioDCOGetPhaseOffset(pph),
+                        pph->_u32_phase_delay);
+        }
+    }
+    if(eDCOENGINE_PATTERN == pDCO->_engine || eDCOENGINE_BITSTREAM == pDCO->_engine)
+    {
+        StampPrintf("=PioDco patterns=");
+        StampPrintf("sft:%ld Hz err:%ld mHz", becaconData._pTX->_i32_pattern_shift_hz,
+                    becaconData._pTX->_i32_pattern_err_millihz);
+        for(int i = 0; i < PIODCO_PATTERN_TONES; ++i)
+        {
+            StampPrintf("t%d:%u w %u b %ld mHz", i, pDCO->_u16_pattern_len[i], 
+                        pDCO->_u16_pattern_len[i] * sizeof(uint32_t), pDCO->_i32_pattern_err_millihz[i]);
+        }
+    }
+
     GPStimeContext *pGPS = becaconData._pTX->_p_oscillator->_pGPStime;
     const uint32_t u32_unixtime_now 
             = becaconData._pTX->_p_oscillator->_pGPStime->_time_data._u32_utime_nmea_last + u64_GPS_last_age_sec;
@@ -96,6 +96,7 @@ int WSPRbeaconCreatePacket(bool sendLongLocator);
 int WSPRbeaconSendPacket(void);
 
 int WSPRbeaconTxScheduler(int verbose);
+int WSPRbeaconSecondsToTx(void);
 
 void WSPRbeaconDumpContext(void);
 
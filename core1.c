@@ -56,6 +56,17 @@
 #include <piodco.h>
 #include <defines.h>
 #include <WSPRbeacon.h>
+#include "persistentStorage.h"
+#include "pico/multicore.h"
+#include "FreqCounter/FreqCounter.h"
+
+static PioDco sDCOcarrier;
+static PioDco sDCOphase[PIODCO_MAX_OUTPUTS - 1];
+static PioDco *spPhaseGroup[PIODCO_MAX_OUTPUTS];
+
+static void Core1PhaseGroupInit(PioDco *p);
+static void Core1SetupEngine(PioDco *p);
+static void Core1RunWorker(PioDco *p);
 
 
 
@@ -64,17 +75,180 @@ void Core1Entry()
 {
     assert_(pWSPR);
 
-    const uint32_t clkhz = PLL_SYS_MHZ * MHz;
-
     PioDco *p = pWSPR->_pTX->_p_oscillator;
     assert_(p);
 
     /* Initialize DCO */
     assert_(0 == PioDCOInit(p, pWSPR->_pTX->_i_tx_gpio));
 
+    const PowerLevel *pLevel = &powerLevels[settingsData.powerLevel];
+    PioDCOSetPins(p, pLevel->pins, pLevel->drive);
+    if (settingsData.phases > 1)
+    {
+        Core1PhaseGroupInit(p);
+    }
+
+    Core1SetupEngine(p);
+
+    if (settingsData.envPin >= 0)
+    {
+        PioDCOEnvelopeInit(p, settingsData.envPin);
+    }
+
+    Core1RunWorker(p);
+}
+
+/// @brief The core1 entry after Core1Resume: the SM, the phase group and the
+/// @brief envelope of DCO are kept, the engine is set up again.
+static void Core1ResumeEntry(void)
+{
+    PioDco *p = pWSPR->_pTX->_p_oscillator;
+
+    Core1SetupEngine(p);
+    Core1RunWorker(p);
+}
+
+/// @brief Stops the DCO worker for the low power mode between transmissions:
+/// @brief core1 is held in reset and the SM and DMA of worker are released.
+/// @attention It is to be called while the DCO is keyed up, the output stops.
+void Core1Suspend(void)
+{
+    multicore_reset_core1();
+    PioDCOSuspend(pWSPR->_pTX->_p_oscillator);
+}
+
+/// @brief Runs the DCO worker again after Core1Suspend, at the system clock
+/// @brief which is set now. The constants of DCO are recalculated for it, and
+/// @brief the engine is set up again by core1 as on its first start.
+void Core1Resume(void)
+{
+    PioDCOSetClock(pWSPR->_pTX->_p_oscillator);
+    multicore_launch_core1(Core1ResumeEntry);
+}
+
+/// @brief Sets up the outputs of PHASES setting as a phase group of the DCO:
+/// @brief on the GPIOs following the RF pins, each 90 degrees after the former.
+/// @param p Ptr to DCO context, the first output.
+static void Core1PhaseGroupInit(PioDco *p)
+{
+    const PowerLevel *pLevel = &powerLevels[settingsData.powerLevel];
+    spPhaseGroup[0] = p;
+    for (int i = 1; i < settingsData.phases; ++i)
+    {
+        assert_(0 == PioDCOInit(&sDCOphase[i - 1], p->_gpio + i * pLevel->pins));
+        PioDCOSetPins(&sDCOphase[i - 1], pLevel->pins, pLevel->drive);
+        spPhaseGroup[i] = &sDCOphase[i - 1];
+    }
+    assert_(0 == PioDCOPhaseGroupInit(spPhaseGroup, settingsData.phases));
+
+    for (int i = 1; i < settingsData.phases; ++i)
+    {
+        PioDCOSetPhaseOffset(spPhaseGroup[i], i * 250);
+    }
+}
+
+/// @brief Sets up the engine of DCO from the settings, on each start of core1:
+/// @brief the band might have changed since the last one, and its duty and
+/// @brief engine with it. The working freq is set last, for the engine.
+/// @param p Ptr to DCO context.
+static void Core1SetupEngine(PioDco *p)
+{
+    PioDCOSetHarmonic(p, settingsData.harmonic);
+    PioDCOSetDuty(p, settingsData.dutyPermille[settingsCurrentBandIndex()]);
+    if (p->_u8_group_n)
+    {
+        /* The phase group has its own worker, fed by core1 like CPU. */
+        PioDCOSetEngine(p, eDCOENGINE_CPU);
+    }
+    else
+    {
+        PioDCOSetEngine(p, (settingsData.bitstreamBands & (1U << settingsCurrentBandIndex()))
+                           ? eDCOENGINE_BITSTREAM : settingsData.dcoEngine);
+    }
+    PioDCOSetLatency(p, settingsData.fifoDepth, settingsData.fifoFlush);
+
+    PioDCOSetNoiseShaping(p, settingsData.mashOrder, settingsData.dither);
+
     /* Set initial freq. */
     assert_(0 == PioDCOSetFreq(p, pWSPR->_pTX->_u32_Txfreqhz, 0U));
+}
+
+/// @brief Runs the worker of the engine selected. It spins forever.
+/// @param p Ptr to DCO context.
+static void Core1RunWorker(PioDco *p)
+{
+    if (p->_u8_group_n)
+    {
+        PioDCOWorkerPhased(p->_apgroup, p->_u8_group_n);
+    }
+
+    switch(p->_engine)
+    {
+        case eDCOENGINE_DMA:
+            PioDCOWorkerDMA(p);
+            break;
+
+        case eDCOENGINE_PATTERN:
+        case eDCOENGINE_BITSTREAM:
+            PioDCOWorkerPattern(p);
+            break;
+
+        case eDCOENGINE_MASH:
+            PioDCOWorkerMASH(p);
+            break;
+
+        case eDCOENGINE_TIMED:
+            PioDCOWorkerTimed(p);
+            break;
+
+        default:
+            PioDCOWorker2(p);
+            break;
+    }
+}
+
+/// @brief The core1 entry of the carrier of Core1MeasureCarrier.
+static void Core1CarrierEntry(void)
+{
+    PioDCOWorker2(&sDCOcarrier);
+}
+
+/// @brief Generates a carrier on RF pin and measures it by the PPS gated
+/// @brief freq counter. It is for the settings console, before core1 and
+/// @brief the DCO of beacon are started.
+/// @param u32_frq_hz The freq of carrier, Hz. No calibration applied.
+/// @param gate_s The gate of counter, s.
+/// @param pi64_millihz Ptr to the freq measured on RF pin, mHz.
+/// @param pharmonic Ptr to the harmonic N, RF pin carries the freq / N.
+/// @return 0 if OK. -1 no free SM, -2 no PPS or invalid gate.
+/// @remark Core1 and the SM are released afterwards.
+int Core1MeasureCarrier(uint32_t u32_frq_hz, int gate_s, int64_t *pi64_millihz, int *pharmonic)
+{
+    PioDco *p = &sDCOcarrier;
+    if(PioDCOInit(p, settingsData.rfPin))
+    {
+        return -1;
+    }
+
+    PioDCOSetHarmonic(p, settingsData.harmonic);
+    PioDCOSetDuty(p, settingsData.dutyPermille[settingsCurrentBandIndex()]);
+    PioDCOSetFreq(p, u32_frq_hz, 0);
+    *pharmonic = p->_u8_harmonic_n;
+
+    multicore_launch_core1(Core1CarrierEntry);
+    PioDCOStart(p);
+
+    FreqCounterContext fc;
+    int iret = FreqCounterInit(&fc, settingsData.rfPin, GPS_PPS_PIN);
+    if(!iret)
+    {
+        iret = FreqCounterMeasure(&fc, gate_s, pi64_millihz) ? -2 : 0;
+        FreqCounterDeinit(&fc);
+    }
+
+    PioDCOStop(p);
+    multicore_reset_core1();
+    pio_sm_unclaim(p->_pio, p->_ism);
 
-    /* Run the main DCO algorithm. It spins forever. */
-    PioDCOWorker2(p);
+    return iret;
 }
@@ -5,6 +5,7 @@
 #include <piodco.h>
 #include <TxChannel.h>
 #include "persistentStorage.h"
+#include "WSPRbeacon.h"
 
 uint32_t CW_SYMBOL_LIST[] =
 {
@@ -68,8 +69,6 @@ uint32_t CW_SYMBOL_LIST[] =
 0x00001dd7,//Z
 };
 
-TxChannelContext *pTX;
-
 static char cwMessage[32];
 static const char* messagePtr;
 static uint32_t bitPattern;
@@ -77,6 +76,37 @@ static int bitPatternCounter;
 int cwMessageState = 0;
 static int charIndex;
 static const int BIT_COUNTER_RESET_VALUE = 4;
+static TxChannelSymbol cwSymbol;// the key state being built, pushed when it changes
+
+// Pushes the key state built so far to the Tx timeline, waiting while the timeline is full
+static void cwFlushSymbol(void)
+{
+	if (cwSymbol._u32_duration_us == 0)
+	{
+		return;
+	}
+
+	while (!TxChannelPushSymbols(&cwSymbol, 1))
+	{
+		if (!TxChannelIsRunning())
+		{
+			TxChannelStart();// the timeline is full, so it can start
+		}
+		tight_loop_contents();
+	}
+	cwSymbol._u32_duration_us = 0;
+}
+
+// Adds a key state to the Tx timeline, merged with the previous one if it is the same
+static void cwKey(uint8_t tone, uint32_t duration_us)
+{
+	if (cwSymbol._u32_duration_us && cwSymbol._u8_tone != tone)
+	{
+		cwFlushSymbol();
+	}
+	cwSymbol._u8_tone = tone;
+	cwSymbol._u32_duration_us += duration_us;
+}
 
 void sendMessageInitBitPattern(void)
 {
@@ -87,7 +117,7 @@ void sendMessageInitBitPattern(void)
 }
 
 
-bool sendMessageProgress(void)
+bool sendMessageProgress(uint32_t dot_us)
 {
 	bool retVal = TRUE;
 	switch (cwMessageState)
@@ -101,12 +131,12 @@ bool sendMessageProgress(void)
 				//printf("%d", bitPattern & 0x01);
 				if ((bitPattern & 0x01))
 				{
-				    PioDCOStart(pTX->_p_oscillator);// turn on the oscillator
+					cwKey(0, dot_us);// carrier on
 					bitPatternCounter = BIT_COUNTER_RESET_VALUE;
 				}
 				else
 				{
-				    PioDCOStop(pTX->_p_oscillator);// turn off the oscillator
+					cwKey(TXCHANNEL_KEY_UP, dot_us);// carrier off, on a whole cycle
 				}
 				bitPatternCounter--;
 				bitPattern = bitPattern >> 1;
@@ -114,6 +144,7 @@ bool sendMessageProgress(void)
 			}
 			else
 			{
+				cwKey(cwSymbol._u8_tone, dot_us);// the key stays as it is for the step to the next character
 
 				messagePtr++;
 				if (*messagePtr)
@@ -137,30 +168,42 @@ char randChar(void)
 	return randCharStr[rand() % 36];
 }
 
+// Adds the message to the Tx timeline, one dot long step per bit of the character patterns
 void sendCwMessage(void)
 {
+	const uint32_t dot_us = 1200000UL / settingsData.cwSpeed;
 	messagePtr = cwMessage;
 	cwMessageState = 0;
-	bool b;
 
 	//printf("Send message CW %s\n",messagePtr);
-	do
+	while (sendMessageProgress(dot_us))
 	{
-		b = sendMessageProgress();
-		sleep_ms(1200 / settingsData.cwSpeed);
-	} while (b);
+	}
 
-	sleep_ms(1000);// wait 1 second
+	cwKey(TXCHANNEL_KEY_UP, 1000 * 1000);// wait 1 second
 }
 
-void handleCW(void)
+// Sends the Tx timeline built so far and waits for its end
+static void cwSendTimeline(void)
 {
+	cwFlushSymbol();
+	if (!TxChannelIsRunning())
+	{
+		TxChannelStart();
+	}
+	while (TxChannelIsRunning())
+	{
+		sleep_ms(10);
+	}
+}
 
-	pTX = TxChannelInit(1000, 0);// 682667 is WSPR symbol duration in microseconds
+void handleCW(void)
+{
 	TxChannelSetFrequency(settingsData.txFreq,0);
 
 	while(true)
 	{
+		TxChannelClear(pWSPR->_pTX);
 
 		//snprintf(cwMessage,32, "%s",settingsData.callsign);
 		sendCwMessage();// send callsign
@@ -189,11 +232,13 @@ void handleCW(void)
 
 		if (settingsData.mode == MODE_CW_BEACON)
 		{
-			sleep_ms(30 * 1000);// wait 30 seconds before retransmitting
+			cwKey(TXCHANNEL_KEY_UP, 30 * 1000 * 1000);// wait 30 seconds before retransmitting
 		}
 		else
 		{
-			sleep_ms(2 * 1000);// wait 30 seconds before retransmitting
+			cwKey(TXCHANNEL_KEY_UP, 2 * 1000 * 1000);// wait 2 seconds before retransmitting
 		}
+
+		cwSendTimeline();
 	}
 }
\ No newline at end of file
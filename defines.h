@@ -90,10 +90,15 @@
 
 #define kHz 1000UL                                                /* Freq. */
 #define MHz 1000000UL
+#define PLL_SYS_MHZ_OVERCLOCK_300MHZ 300UL
 #define PLL_SYS_MHZ_OVERCLOCK_270MHZ 270UL
+#define PLL_SYS_MHZ_OVERCLOCK_250MHZ 250UL
 #define PLL_SYS_MHZ_OVERCLOCK_200MHZ 200UL
 #define PLL_SYS_MHZ_DEFAULT 125UL
-#define PLL_SYS_MHZ PLL_SYS_MHZ_OVERCLOCK_200MHZ
+#define PLL_SYS_MHZ PLL_SYS_MHZ_OVERCLOCK_200MHZ     /* The default profile. */
+#define NUM_SYSCLK_PROFILES 5
+#define PLL_SYS_MHZ_LOWPOWER 48UL           /* Between transmissions. */
+#define LOWPOWER_WAKE_SECS 5                /* Full clock before a slot. */
                                                              /* WSPR defs. */
 #define WSPR_FREQ_STEP_MILHZ    2930UL     /* FSK freq.bin (*2 this time). */
 #define WSPR_MAX_GPS_DISCONNECT_TM  \
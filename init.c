@@ -55,27 +55,197 @@
 
 #include "pico/stdlib.h"
 #include "hardware/clocks.h"
+#include "hardware/uart.h"
 #include "hardware/vreg.h"
+#include "hardware/watchdog.h"
 #include "defines.h"
+#include "pico-hf-oscillator/lib/utility.h"
+#include "persistentStorage.h"
 
+#define SYSCLK_PROBE_MAGIC 0x5C10C4B3UL  /* Watchdog scratch[0] while probing. */
+#define SYSCLK_PROBE_MS 100                      /* Duration of CPU stress. */
+
+/// @brief Sets the core voltage suitable for a system clock.
+/// @param sysclk_mhz The system clock, MHz.
+static void InitSetVoltage(uint32_t sysclk_mhz)
+{
+    enum vreg_voltage voltage = VREG_VOLTAGE_DEFAULT;
+    if (sysclk_mhz > 250)
+    {
+        voltage = VREG_VOLTAGE_1_30;
+    }
+    else if (sysclk_mhz > 200)
+    {
+        voltage = VREG_VOLTAGE_1_25;
+    }
+    else if (sysclk_mhz > 125)
+    {
+        voltage = VREG_VOLTAGE_1_20;
+    }
+    else if (sysclk_mhz <= PLL_SYS_MHZ_LOWPOWER)
+    {
+        voltage = VREG_VOLTAGE_0_95;
+    }
+
+    vreg_set_voltage(voltage);
+    sleep_ms(10);
+}
+
+/// @brief Sets clk_peri, which clocks UARTs, to the system clock.
+static void InitSetPeriClock(void)
+{
+    const uint32_t clkhz = clock_get_hz(clk_sys);
+    clock_configure(clk_peri, 0,
+                    CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
+                    clkhz,
+                    clkhz);
+}
+
+/// @brief Reads back the baud rate of UART from its divisor.
+/// @param uart The UART.
+/// @return The baud rate, 0 if UART is disabled.
+static uint32_t InitGetUartBaud(uart_inst_t *uart)
+{
+    if (!uart_is_enabled(uart))
+    {
+        return 0;
+    }
+
+    /* The divisor is 64 * IBRD + FBRD = 4 * clk_peri / baud. */
+    const uart_hw_t *hw = uart_get_hw(uart);
+    const uint32_t div = 64 * hw->ibrd + hw->fbrd;
+    return (uint32_t)((4ULL * clock_get_hz(clk_peri) + div / 2) / div);
+}
+
+/// @brief Checks whether the system runs properly at the current clock.
+/// @return true if the measured clock is right and the CPU computes right.
+/// @remark A CPU hang is caught by the watchdog armed by caller.
+static bool InitProbeSysClock(void)
+{
+    const uint32_t expected_khz = clock_get_hz(clk_sys) / kHz;
+    const uint32_t measured_khz = frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_SYS);
+    if (measured_khz + expected_khz / 100 < expected_khz
+     || measured_khz > expected_khz + expected_khz / 100)
+    {
+        return false;
+    }
+
+    /* Run the same PRN sequence twice, a marginal clock shows up as a
+       mismatch or as a hang. */
+    const absolute_time_t tend = make_timeout_time_ms(SYSCLK_PROBE_MS);
+    while (!time_reached(tend))
+    {
+        static volatile uint32_t seed = 0x1234567;      /* Avoids folding. */
+        uint32_t seed1 = seed, seed2 = seed;
+        uint32_t sum1 = 0, sum2 = 0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            PRN32(&seed1);
+            sum1 += seed1 * (uint32_t)i;
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            PRN32(&seed2);
+            sum2 += seed2 * (uint32_t)i;
+        }
+        if (sum1 != sum2)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
 
 /// @brief Initializes Pi pico low level hardware.
-void InitPicoHW(void)
+/// @param sysclk_mhz The system clock requested, MHz. One of sysClockProfiles.
+/// @return The system clock actually set, MHz.
+/// @remark If the requested clock can't be set or doesn't pass the probe, the
+/// @remark next lower profile is tried. If the probe hung on previous boot, it
+/// @remark is known from the watchdog scratch and that profile is skipped.
+uint32_t InitPicoHW(uint32_t sysclk_mhz)
 {
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
 
-    if (PLL_SYS_MHZ > 125)
+    int iprofile = NUM_SYSCLK_PROFILES - 1;
+    while (iprofile > 0 && sysClockProfiles[iprofile] > sysclk_mhz)
+    {
+        --iprofile;
+    }
+
+    if (watchdog_caused_reboot() && SYSCLK_PROBE_MAGIC == watchdog_hw->scratch[0])
     {
-        vreg_set_voltage(VREG_VOLTAGE_1_20);
-        sleep_ms(10);
+        const uint32_t failed_mhz = watchdog_hw->scratch[1];
+        while (iprofile > 0 && sysClockProfiles[iprofile] >= failed_mhz)
+        {
+            --iprofile;
+        }
     }
 
-    const uint32_t clkhz = PLL_SYS_MHZ * 1000000L;
-    set_sys_clock_khz(clkhz / kHz, true);
+    for (;; --iprofile)
+    {
+        const uint32_t mhz = sysClockProfiles[iprofile];
 
-    clock_configure(clk_peri, 0,
-                    CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
-                    PLL_SYS_MHZ * MHZ,
-                    PLL_SYS_MHZ * MHZ);
+        watchdog_hw->scratch[0] = SYSCLK_PROBE_MAGIC;
+        watchdog_hw->scratch[1] = mhz;
+        watchdog_enable(10 * SYSCLK_PROBE_MS, true);
+
+        InitSetVoltage(mhz);
+        const bool ok = set_sys_clock_khz(mhz * kHz, false) && InitProbeSysClock();
+
+        watchdog_disable();
+        watchdog_hw->scratch[0] = 0;
+
+        if (ok || 0 == iprofile)
+        {
+            break;
+        }
+
+        /* Back to a safe clock before the voltage is lowered. */
+        set_sys_clock_khz(PLL_SYS_MHZ_DEFAULT * kHz, true);
+    }
+
+    InitSetPeriClock();
+
+    return clock_get_hz(clk_sys) / MHz;
+}
+
+/// @brief Switches the system clock at run time, e.g. to the low power profile
+/// @brief between transmissions and back. The core voltage follows it and the
+/// @brief UARTs keep their baud rates.
+/// @param sysclk_mhz The system clock, MHz. A profile that passed InitPicoHW
+/// @param sysclk_mhz or PLL_SYS_MHZ_LOWPOWER.
+/// @return The system clock set, MHz.
+/// @remark The timer and watchdog run from clk_ref, so alarms and repeating
+/// @remark timers aren't affected. The DCO must be suspended meanwhile.
+uint32_t InitSwitchSysClock(uint32_t sysclk_mhz)
+{
+    uint32_t baud[2];
+    baud[0] = InitGetUartBaud(uart0);
+    baud[1] = InitGetUartBaud(uart1);
+
+    /* The core voltage is raised before the clock and lowered after it. */
+    const bool up = sysclk_mhz * MHz > clock_get_hz(clk_sys);
+    if (up)
+    {
+        InitSetVoltage(sysclk_mhz);
+    }
+    set_sys_clock_khz(sysclk_mhz * kHz, true);
+    if (!up)
+    {
+        InitSetVoltage(sysclk_mhz);
+    }
+
+    InitSetPeriClock();
+    if (baud[0])
+    {
+        uart_set_baudrate(uart0, baud[0]);
+    }
+    if (baud[1])
+    {
+        uart_set_baudrate(uart1, baud[1]);
+    }
+
+    return clock_get_hz(clk_sys) / MHz;
 }
@@ -73,6 +73,9 @@
 #include "pico/bootrom.h"
 #include "tusb.h"
 #include "cw_beacon.h"
+#ifdef PIODCO_KERNEL_PROFILE
+#include "dcokernel.h"
+#endif
 
 #define CONFIG_GPS_SOLUTION_IS_MANDATORY NO
 #define CONFIG_GPS_RELY_ON_PAST_SOLUTION NO
@@ -96,6 +99,31 @@ void rebootIntoFlashUpdateMode(void)
 }
 
 WSPRbeaconContext *pWB;
+
+static bool sLowPower = false;
+static uint32_t sSysClockMhz;// The clock of this boot, the settings one or the probe fallback.
+
+/// @brief Switches the low power mode between transmissions: the DCO worker
+/// @brief is stopped and the system clock and core voltage are lowered, until
+/// @brief LOWPOWER_WAKE_SECS before the next transmission.
+/// @param secsToTx The seconds to the start of next transmission.
+static void wsprPowerSave(int secsToTx)
+{
+    const bool idle = settingsData.lowPower && secsToTx > LOWPOWER_WAKE_SECS;
+    if (idle && !sLowPower)
+    {
+        Core1Suspend();
+        InitSwitchSysClock(PLL_SYS_MHZ_LOWPOWER);
+        sLowPower = true;
+    }
+    else if (!idle && sLowPower)
+    {
+        InitSwitchSysClock(sSysClockMhz);
+        Core1Resume();
+        sLowPower = false;
+    }
+}
+
 void wsprLoop(void)
 {
         while(true)
@@ -117,7 +145,14 @@ void wsprLoop(void)
 
         while(!ppsTriggered)
         {
-            tight_loop_contents();
+            if (sLowPower)
+            {
+                __wfi();// Woken by PPS, timer, UART or USB interrupts
+            }
+            else
+            {
+                tight_loop_contents();
+            }
         }
 
         watchdog_update();
@@ -127,6 +162,7 @@ const bool debugMessages = true;
 const bool debugMessages = false;
 #endif
         WSPRbeaconTxScheduler(debugMessages);
+        wsprPowerSave(WSPRbeaconSecondsToTx());
         ppsTriggered = false;
     }
 }
@@ -134,12 +170,21 @@ const bool debugMessages = false;
 int main()
 {
     repeating_timer_t oneSecondTimer;// Used in conjunction with the RTC for no GPS operation
-    InitPicoHW();
+    settingsReadFromFlash(false);
+    /* A fallback of the probe is for this boot only, the settings keep the
+       clock asked for, so a marginal probe doesn't lower it for good. */
+    sSysClockMhz = InitPicoHW(settingsData.sysClockMhz);
+
     gpio_init(BTN_PIN);
     gpio_set_dir(BTN_PIN, GPIO_IN);
     gpio_set_pulls(BTN_PIN,false,true);
 
     StampPrintf("\n");
+#if defined(PIODCO_KERNEL_PROFILE) && defined(PIODCO_KERNEL_CYCLES_PER_WORD)
+    const uint32_t u32kernel = PioDCOKernelProfile();
+    StampPrintf("DCO kernel %lu.%02lu cycles per word, budget %d", (unsigned long)(u32kernel >> 8),
+                (unsigned long)(((u32kernel & 0xFF) * 100) >> 8), PIODCO_KERNEL_CYCLES_PER_WORD);
+#endif
     int cdcTimeoutCounter = 0;
     bool buttonHeldAtBoot = gpio_get(BTN_PIN);
     
@@ -154,12 +199,18 @@ int main()
     }
 #endif    
 
+    if (sSysClockMhz != settingsData.sysClockMhz)
+    {
+        printf("SYSCLK %d MHz failed the probe, %lu MHz is used for this boot\n",
+               settingsData.sysClockMhz, sSysClockMhz);
+    }
+
     handleSettings(buttonHeldAtBoot);
 
     pWB = WSPRbeaconInit(
         settingsData.callsign,/* the Callsign. */
         settingsData.locator,/* the default QTH locator if GPS isn't used. */
-        settingsData.outputPowerDbm,/* Tx power, dbm. */
+        settingsReportedPowerDbm(),/* Tx power, dbm, of the power level. */
         bandFrequencies[settingsData.bandIndex] + ((bandFrequencies[settingsData.bandIndex] / 1E6) * settingsData.freqCalibrationPPM),// bottom of WSPR freq range
         settingsData.initialOffsetInWSPRFreqRange,           /* the carrier freq. */
         settingsData.rfPin       /* RF output GPIO pin. */
@@ -6,10 +6,12 @@
 #include "tusb.h"
 
 #include "hardware/watchdog.h"
+#include "hardware/clocks.h"
 #include "persistentStorage.h"
+#include "protos.h"
 
 const uint64_t  MAGIC_NUMBER    = 0x5069636F57535052;// 'PicoWSPR  
-const uint32_t  CURRENT_VERSION = 14;
+const uint32_t  CURRENT_VERSION = 26;
 
 SettingsData settingsData;
 
@@ -17,8 +19,10 @@ SettingsData settingsData;
 const uint32_t FLASH_TARGET_OFFSET = (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE);
 const uint8_t *flash_target_contents = (const uint8_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
 
-const uint32_t bandNames[NUM_BANDS] = { 160, 80, 40, 30, 20, 17, 15, 12, 10 };
+const uint32_t bandNames[NUM_BANDS] = { 2200, 630, 160, 80, 40, 30, 20, 17, 15, 12, 10, 6 };
 const uint32_t bandFrequencies[NUM_BANDS] = {
+          137400,
+          475600,
          1838000,
          3570000,
          7040000,
@@ -27,10 +31,25 @@ const uint32_t bandFrequencies[NUM_BANDS] = {
         18106000,
         21096000,
         24926000,
-        28126000
+        28126000,
+        50294400
 };
 
 const char *OPERATING_MODES[NUM_OPERATING_MODES] = {"WSPR","CW","SLOWMORSE","FT8","APRS"};
+const uint32_t sysClockProfiles[NUM_SYSCLK_PROFILES] = {
+          PLL_SYS_MHZ_DEFAULT,
+          PLL_SYS_MHZ_OVERCLOCK_200MHZ,
+          PLL_SYS_MHZ_OVERCLOCK_250MHZ,
+          PLL_SYS_MHZ_OVERCLOCK_270MHZ,
+          PLL_SYS_MHZ_OVERCLOCK_300MHZ };
+const char *DCO_ENGINES[eDCOENGINE_NUM] = {"CPU","DMA","PATTERN","MASH","TIMED","BITSTREAM"};
+const PowerLevel powerLevels[NUM_POWER_LEVELS] = {
+        { 1, GPIO_DRIVE_STRENGTH_2MA,   2,  3 },
+        { 1, GPIO_DRIVE_STRENGTH_4MA,   4,  7 },// The GPIO default
+        { 1, GPIO_DRIVE_STRENGTH_8MA,   8, 10 },
+        { 1, GPIO_DRIVE_STRENGTH_12MA, 12, 12 },
+        { 2, GPIO_DRIVE_STRENGTH_12MA, 12, 14 },
+        { 4, GPIO_DRIVE_STRENGTH_12MA, 12, 15 } };
 
 /**
  * Parses a command of the form KEY=VALUE.
@@ -89,8 +108,8 @@ void settingsReadFromFlash(bool forceReset)
     {   
         settingsData.magicNumber        =   MAGIC_NUMBER;
         settingsData.settingsVersion    =   CURRENT_VERSION;
-        //settingsData.bandsBitPattern    =   0B100;// 40m
-        settingsData.bandIndex = 2;// 40m
+        //settingsData.bandsBitPattern    =   0B10000;// 40m
+        settingsData.bandIndex = 4;// 40m
         settingsData.freqCalibrationPPM =   0;// Default this no calibration offset
         memset(settingsData.callsign, 0x00, 16);// completely erase
         memset(settingsData.locator, 0x00, 16);// completely erase
@@ -99,12 +118,31 @@ void settingsReadFromFlash(bool forceReset)
         settingsData.frequencyHop       = false;
         settingsData.gpsMode            = GPS_MODE_ON;
         settingsData.initialOffsetInWSPRFreqRange = 0;
-        settingsData.outputPowerDbm = 13;
         settingsData.gpsLocation = 0;
         settingsData.longLocator = 0;
         settingsData.mode = MODE_CW_BEACON;
         settingsData.cwSpeed = 5;
         settingsData.txFreq = 7010000;//7.050Mhz        
+        settingsData.dcoEngine = eDCOENGINE_CPU;
+        settingsData.mashOrder = 2;
+        settingsData.dither = 0;
+        settingsData.sysClockMhz = PLL_SYS_MHZ;
+        settingsData.harmonic = 0;// Auto
+        settingsData.envPin = -1;// No keying envelope pin
+        settingsData.fifoDepth = PIODCO_FIFO_DEPTH;// Full FIFO
+        settingsData.fifoFlush = 0;
+        settingsData.bitstreamBands = 0;// Bitstream engine on no band
+        settingsData.lowPower = 0;
+        settingsData.phases = 1;// RFPIN only
+        settingsData.powerLevel = 1;// 1 pin, 4 mA
+        for(int i=0;i<NUM_BANDS;i++)
+        {
+            settingsData.dutyPermille[i] = 500;// 50%
+        }
+        for(int i=0;i<NUM_POWER_LEVELS;i++)
+        {
+            settingsData.powerCalDbm[i] = powerLevels[i].defaultDbm;
+        }
 
         settingsWriteToFlash();
     }
@@ -183,7 +221,7 @@ bool settingsCheckSettings(void)
 
             printf("OFFSET:%d\n", settingsData.initialOffsetInWSPRFreqRange);
             printf("FREQHOP:%s\n", settingsData.frequencyHop?"On":"Off");
-            printf("POWER:%d\n", settingsData.outputPowerDbm);
+            printf("POWER:%d dBm (reported %d dBm)\n", settingsData.powerCalDbm[settingsData.powerLevel], settingsReportedPowerDbm());
             break;
         case MODE_CW_BEACON:
         case MODE_SLOW_MORSE:
@@ -200,7 +238,56 @@ bool settingsCheckSettings(void)
     printf("CALPPM:%d\n", settingsData.freqCalibrationPPM);
 
     printf("RFPIN:%d\n", settingsData.rfPin);
+    const PowerLevel *pLevel = &powerLevels[settingsData.powerLevel];
+    printf("POWERLEVEL:%d (%d GPIO at %d mA)\n", settingsData.powerLevel, pLevel->pins, pLevel->driveMa);
+    if (settingsData.phases > 1)
+    {
+        printf("PHASES:%d (GPIO %d to %d, 90 degrees apart)\n", settingsData.phases, settingsData.rfPin, settingsData.rfPin + settingsData.phases * pLevel->pins - 1);
+    }
+
+    if (settingsData.envPin >= 0)
+    {
+        printf("ENVPIN:%d\n", settingsData.envPin);
+    }
+    else
+    {
+        printf("ENVPIN:OFF\n");
+    }
+
+    printf("ENGINE:%s\n", DCO_ENGINES[settingsData.dcoEngine]);
+    if (settingsData.dcoEngine == eDCOENGINE_MASH)
+    {
+        printf("MASH:%d\n", settingsData.mashOrder);
+        printf("DITHER:%s\n", settingsData.dither?"On":"Off");
+    }
+
+    printf("FIFODEPTH:%d\n", settingsData.fifoDepth);
+    printf("FIFOFLUSH:%s\n", settingsData.fifoFlush?"On":"Off");
+
+    const uint32_t runningMhz = clock_get_hz(clk_sys) / 1000000UL;
+    if (runningMhz != settingsData.sysClockMhz)
+    {
+        printf("SYSCLK:%d MHz (failed the probe, %lu MHz this boot)\n", settingsData.sysClockMhz, runningMhz);
+    }
+    else
+    {
+        printf("SYSCLK:%d MHz\n", settingsData.sysClockMhz);
+    }
+    printf("LOWPOWER:%s\n", settingsData.lowPower?"On":"Off");
 
+    const uint32_t duty = settingsData.dutyPermille[settingsCurrentBandIndex()];
+    printf("DUTY:%d.%d%% (%dm)\n", duty / 10, duty % 10, bandNames[settingsCurrentBandIndex()]);
+    printf("BITSTREAM:%s (%dm)\n", (settingsData.bitstreamBands & (1U << settingsCurrentBandIndex()))?"On":"Off",
+           bandNames[settingsCurrentBandIndex()]);
+
+    if (settingsData.harmonic)
+    {
+        printf("HARMONIC:%d\n", settingsData.harmonic);
+    }
+    else
+    {
+        printf("HARMONIC:AUTO\n");
+    }
   
     printf("MODE:%s\n",OPERATING_MODES[settingsData.mode]);
 
@@ -248,6 +335,36 @@ int bandIndexFromString(char *bandString)
 
     return -1; // band not found
 }
+// The band of the current mode, the CW modes use the band nearest to TXFREQ
+int settingsCurrentBandIndex(void)
+{
+    if (settingsData.mode == MODE_WSPR)
+    {
+        return settingsData.bandIndex;
+    }
+
+    int nearest = 0;
+    for(int i=1; i<NUM_BANDS; i++)
+    {
+        if (abs((int32_t)(bandFrequencies[i] - settingsData.txFreq)) < abs((int32_t)(bandFrequencies[nearest] - settingsData.txFreq)))
+        {
+            nearest = i;
+        }
+    }
+
+    return nearest;
+}
+
+// The calibrated power of the current power level, as WSPR reports it: 0 to 60 dBm ending in 0, 3 or 7
+int settingsReportedPowerDbm(void)
+{
+    const int dbm = max(0, min(60, settingsData.powerCalDbm[settingsData.powerLevel]));
+    const int units = dbm % 10;
+    const int snapped = units <= 1 ? 0 : units <= 5 ? 3 : units <= 8 ? 7 : 10;
+
+    return dbm - units + snapped;
+}
+
 #ifdef BANDS_BIT_PATTERN   
 int findNextBandIndex(int currentIndex)
 {
@@ -266,6 +383,41 @@ int findNextBandIndex(int currentIndex)
 }
 #endif
 
+// The carrier of the current band, or TXFREQ.
+static uint32_t settingsCarrierFreq(void)
+{
+    return (settingsData.mode == MODE_WSPR) ? bandFrequencies[settingsData.bandIndex] : settingsData.txFreq;
+}
+
+// Measure the carrier of the current band or TXFREQ by the PPS gated counter, and
+// work out the CALPPM which would correct the error of Pico crystal.
+static void settingsFreqCount(int gateSecs)
+{
+    const uint32_t freq = settingsCarrierFreq();
+
+    printf("\nCounting RF pin %d at %lu Hz for %d s, GPS PPS is needed on pin %d ...\n", 
+           settingsData.rfPin, freq, gateSecs, GPS_PPS_PIN);
+
+    int64_t measuredMilliHz;
+    int harmonic;
+    const int result = Core1MeasureCarrier(freq, gateSecs, &measuredMilliHz, &harmonic);
+    if (result)
+    {
+        printf("\nFailed: %s\n", (result == -1) ? "no free PIO state machine" : "no GPS PPS or invalid time");
+        return;
+    }
+
+    // The RF pin carries the fundamental in harmonic mode.
+    const int64_t expectedMilliHz = (int64_t)freq * 1000LL / harmonic;
+    const int64_t errorMilliHz = measuredMilliHz - expectedMilliHz;
+    const int64_t errorPpb = errorMilliHz * 1000000000LL / expectedMilliHz;
+
+    printf("\nFCOUNT:%lld.%03lld Hz (%lu Hz / %d), error %lld mHz, %lld ppb\n", 
+           measuredMilliHz / 1000, measuredMilliHz % 1000, freq, harmonic, errorMilliHz, errorPpb);
+    printf("CALPPM %d would correct it, now %d\n", 
+           (int)((-errorPpb + (errorPpb < 0 ? 500 : -500)) / 1000), settingsData.freqCalibrationPPM);
+}
+
 void handleSettings(bool forceSettingsEntry)
 {
     settingsReadFromFlash(false);
@@ -335,6 +487,11 @@ void handleSettings(bool forceSettingsEntry)
                 }
             }
 
+            if (strcmp(line,"FCOUNT") == 0)
+            {
+                settingsFreqCount(10);
+            }
+
             if (strcmp(line,"RESET") == 0)
             {
                 printf("Clearing settings.\n");
@@ -436,6 +593,12 @@ void handleSettings(bool forceSettingsEntry)
                         break;
                     }
 
+                    if (strcmp("FCOUNT", key) == 0)
+                    {
+                        settingsFreqCount(atoi(value));
+                        break;
+                    }
+
                     if (strcmp("CALPPM", key) == 0)
                     {
                         settingsData.freqCalibrationPPM = atoi(value);
@@ -494,11 +657,36 @@ void handleSettings(bool forceSettingsEntry)
 
                     if (strcmp("POWER", key) == 0)
                     {
-                        settingsData.outputPowerDbm = atoi(value);
+                        int newDbm = atoi(value);
+                        if (newDbm >= 0 && newDbm <= 60)
+                        {
+                            settingsData.powerCalDbm[settingsData.powerLevel] = newDbm;
 
-                        printf("\nSetting Power to %d dBm\n",settingsData.outputPowerDbm);
+                            printf("\nSetting Power of level %d to %d dBm\n", settingsData.powerLevel, newDbm);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: Power must be 0 to 60 dBm\n");
+                        }
+                        break;
+                    }
 
-                        settingsAreDirty = true;
+                    if (strcmp("POWERLEVEL", key) == 0)
+                    {
+                        int newLevel = atoi(value);
+                        if (newLevel >= 0 && newLevel < NUM_POWER_LEVELS)
+                        {
+                            settingsData.powerLevel = newLevel;
+
+                            printf("\nSetting Power level to %d (%d GPIO at %d mA, %d dBm)\n", newLevel,
+                                   powerLevels[newLevel].pins, powerLevels[newLevel].driveMa, settingsData.powerCalDbm[newLevel]);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: Power level must be 0 to %d\n", NUM_POWER_LEVELS - 1);
+                        }
                         break;
                     }
 
@@ -546,6 +734,222 @@ void handleSettings(bool forceSettingsEntry)
                         break;
                     }      
                     
+                    if (strcmp("ENGINE", key) == 0)
+                    {
+                        int newEngine = -1;
+
+                        for(int i=0;i<eDCOENGINE_NUM;i++)
+                        {
+                            if (strcmp(DCO_ENGINES[i],value) == 0)
+                            {
+                                newEngine = i;
+                                break;
+                            }
+                        }
+
+                        if (newEngine != -1)
+                        {
+                            settingsData.dcoEngine = newEngine;
+
+                            printf("\nSetting DCO engine to %s\n",DCO_ENGINES[newEngine]);
+
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nInvalid DCO engine\n");
+                        }
+                        break;
+                    }
+
+                    if (strcmp("MASH", key) == 0)
+                    {
+                        int mashOrder = atoi(value);
+                        if (mashOrder >= 1 && mashOrder <= 3)
+                        {
+                            // The word of MASH goes below zero unless the fundamental is low enough.
+                            const int fitOrder = PioDCOCalcMASHOrder(settingsData.sysClockMhz * 1000000UL, settingsData.harmonic,
+                                                                     mashOrder, settingsCarrierFreq());
+                            if (fitOrder < mashOrder)
+                            {
+                                printf("\nERROR: MASH order %d doesn't fit %lu Hz at this harmonic and system clock, the highest is %d\n",
+                                       mashOrder, (unsigned long)settingsCarrierFreq(), fitOrder);
+                                break;
+                            }
+
+                            settingsData.mashOrder = mashOrder;
+
+                            printf("\nSetting MASH order to %d\n",settingsData.mashOrder);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: MASH order must be between 1 and 3 inclusive\n");
+                        }
+                        break;
+                    }
+
+                    if (strcmp("DITHER", key) == 0)
+                    {
+                        settingsData.dither = (strcmp(value,"ON") == 0);
+
+                        printf("\nSetting dither to %s\n", settingsData.dither?"On":"Off");
+                        settingsAreDirty = true;
+                        break;
+                    }
+
+                    if (strcmp("FIFODEPTH", key) == 0)
+                    {
+                        int newDepth = atoi(value);
+                        if (newDepth >= 1 && newDepth <= PIODCO_FIFO_DEPTH)
+                        {
+                            settingsData.fifoDepth = newDepth;
+                            printf("\nSetting RF oscillator FIFO depth to %d\n", settingsData.fifoDepth);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: FIFO depth must be between 1 and %d\n", PIODCO_FIFO_DEPTH);
+                        }
+                        break;
+                    }
+
+                    if (strcmp("PHASES", key) == 0)
+                    {
+                        int newPhases = atoi(value);
+                        if (newPhases == 1 || newPhases == 2 || newPhases == 4)
+                        {
+                            settingsData.phases = newPhases;
+                            printf("\nSetting RF outputs to %d, 90 degrees apart\n", settingsData.phases);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: Phases must be 1, 2 or 4\n");
+                        }
+                        break;
+                    }
+
+                    if (strcmp("LOWPOWER", key) == 0)
+                    {
+                        settingsData.lowPower = (strcmp(value,"ON") == 0);
+
+                        printf("\nSetting low power between transmissions to %s\n", settingsData.lowPower?"On":"Off");
+                        settingsAreDirty = true;
+                        break;
+                    }
+
+                    if (strcmp("FIFOFLUSH", key) == 0)
+                    {
+                        settingsData.fifoFlush = (strcmp(value,"ON") == 0);
+
+                        printf("\nSetting FIFO flush on frequency change to %s\n", settingsData.fifoFlush?"On":"Off");
+                        settingsAreDirty = true;
+                        break;
+                    }
+
+                    if (strcmp("ENVPIN", key) == 0)
+                    {
+                        if (strcmp(value,"OFF") == 0)
+                        {
+                            settingsData.envPin = -1;
+                            printf("\nSetting keying envelope pin to OFF\n");
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            int newPin = atoi(value);
+                            if (newPin >= 0 && newPin <= 28 && newPin != settingsData.rfPin)
+                            {
+                                settingsData.envPin = newPin;
+                                printf("\nSetting keying envelope pin to %d\n", settingsData.envPin);
+                                settingsAreDirty = true;
+                            }
+                            else
+                            {
+                                printf("\nERROR: Envelope pin must be OFF or a GPIO other than RFPIN\n");
+                            }
+                        }
+                        break;
+                    }
+
+                    if (strcmp("DUTY", key) == 0)
+                    {
+                        int newDuty = atoi(value);
+                        if (newDuty >= PIODCO_DUTY_MIN_PERMILLE && newDuty <= PIODCO_DUTY_MAX_PERMILLE)
+                        {
+                            settingsData.dutyPermille[settingsCurrentBandIndex()] = newDuty;
+
+                            printf("\nSetting duty of %dm band to %d.%d%%\n", bandNames[settingsCurrentBandIndex()], newDuty / 10, newDuty % 10);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: Duty must be between %d and %d per mille\n", PIODCO_DUTY_MIN_PERMILLE, PIODCO_DUTY_MAX_PERMILLE);
+                        }
+                        break;
+                    }
+
+                    if (strcmp("BITSTREAM", key) == 0)
+                    {
+                        if (strcmp(value,"ON") == 0)
+                        {
+                            settingsData.bitstreamBands |= 1U << settingsCurrentBandIndex();
+                        }
+                        else
+                        {
+                            settingsData.bitstreamBands &= ~(1U << settingsCurrentBandIndex());
+                        }
+
+                        printf("\nSetting bitstream engine of %dm band to %s\n", bandNames[settingsCurrentBandIndex()],
+                               (settingsData.bitstreamBands & (1U << settingsCurrentBandIndex()))?"On":"Off");
+                        settingsAreDirty = true;
+                        break;
+                    }
+
+                    if (strcmp("HARMONIC", key) == 0)
+                    {
+                        int newHarmonic = (strcmp(value,"AUTO") == 0) ? 0 : atoi(value);
+                        if (newHarmonic == 0 || newHarmonic == 1 || newHarmonic == 3 || newHarmonic == 5 || newHarmonic == 7)
+                        {
+                            settingsData.harmonic = newHarmonic;
+
+                            printf("\nSetting harmonic to %s\n", value);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: Harmonic must be AUTO, 1, 3, 5 or 7\n");
+                        }
+                        break;
+                    }
+
+                    if (strcmp("SYSCLK", key) == 0)
+                    {
+                        uint32_t newClock = atoi(value);
+                        int i;
+                        for(i=0;i<NUM_SYSCLK_PROFILES;i++)
+                        {
+                            if (sysClockProfiles[i] == newClock)
+                            {
+                                break;
+                            }
+                        }
+
+                        if (i < NUM_SYSCLK_PROFILES)
+                        {
+                            settingsData.sysClockMhz = newClock;
+
+                            printf("\nSetting system clock to %d MHz. It takes effect after REBOOT\n",settingsData.sysClockMhz);
+                            settingsAreDirty = true;
+                        }
+                        else
+                        {
+                            printf("\nERROR: System clock must be one of 125, 200, 250, 270, 300 MHz\n");
+                        }
+                        break;
+                    }
+
                     if (strcmp("CWSPEED", key) == 0)
                     {
                         settingsData.cwSpeed = atoi(value);
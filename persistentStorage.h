@@ -5,11 +5,22 @@
 #include <ctype.h>
 #include "hardware/flash.h"
 #include "hardware/sync.h"
+#include <piodco.h>
+#include <defines.h>
 
 #define MAX_KEY 32
 #define MAX_VAL 32
 
-#define NUM_BANDS 9
+#define NUM_BANDS 12
+#define NUM_POWER_LEVELS 6
+
+/* RF output pins driven in parallel and their drive strength. */
+typedef struct {
+    uint8_t     pins;
+    enum gpio_drive_strength drive;
+    uint8_t     driveMa;
+    int8_t      defaultDbm;// Estimated into 50 ohms, until calibrated
+} PowerLevel;
 
 extern const uint64_t  MAGIC_NUMBER ;
 extern const uint32_t  CURRENT_VERSION;
@@ -26,13 +37,26 @@ typedef struct  {
     uint32_t    gpsMode;   
     uint32_t    rfPin; 
     int32_t     initialOffsetInWSPRFreqRange;
-    uint32_t    outputPowerDbm;
     uint32_t    frequencyHop;
     uint32_t    gpsLocation;
     uint32_t    longLocator;
     uint32_t    mode;
     uint32_t    cwSpeed;
     uint32_t    txFreq;
+    uint32_t    dcoEngine;
+    uint32_t    mashOrder;
+    uint32_t    dither;
+    uint32_t    sysClockMhz;
+    uint32_t    harmonic;
+    uint16_t    dutyPermille[NUM_BANDS];
+    int32_t     envPin;
+    uint32_t    fifoDepth;
+    uint32_t    fifoFlush;
+    uint32_t    bitstreamBands;
+    uint32_t    lowPower;
+    uint32_t    phases;
+    uint32_t    powerLevel;
+    int8_t      powerCalDbm[NUM_POWER_LEVELS];
 } SettingsData;
 
 enum gpsModes {GPS_MODE_OFF = 0, GPS_MODE_ON};
@@ -46,6 +70,9 @@ extern const uint8_t *flash_target_contents;
 
 extern const uint32_t bandNames[NUM_BANDS];
 extern const uint32_t bandFrequencies[NUM_BANDS];
+extern const uint32_t sysClockProfiles[NUM_SYSCLK_PROFILES];
+extern const char *DCO_ENGINES[eDCOENGINE_NUM];
+extern const PowerLevel powerLevels[NUM_POWER_LEVELS];
 
 void settingsReadFromFlash(bool forceReset);
 void settingsWriteToFlash(void);
@@ -53,6 +80,8 @@ bool settingsCheckSettings(void);
 int parse_kv(const char *input, char *key, char *value) ;
 void convertToUpper(char str[]);
 int bandIndexFromString(char *bandString);
+int settingsCurrentBandIndex(void);
+int settingsReportedPowerDbm(void);
 
 void handleSettings(bool forceSettingsEntryd);
 int findNextBandIndex(int currentIndex);
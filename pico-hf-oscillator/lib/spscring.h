@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  spscring.h - Lock-free single producer single consumer ring of any type.
+//
+//  DESCRIPTION
+//      The producer and the consumer might be a task and an ISR, or core0 and
+//  core1. Each side writes its own index only; the element is published by
+//  a release store of the head and is freed by a release store of the tail,
+//  so no lock and no interrupt masking is needed.
+//
+//          SPSC_RING_DEFINE(MyRing, MyElement, 64)
+//
+//  defines type MyRing and MyRingClear/Count/Push/Pop/Peek/Drop/DropAll.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-hf-oscillator
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef SPSCRING_H_
+#define SPSCRING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Always inlined, so the callers placed in RAM stay off flash. */
+#define SPSC_RING_INLINE static inline __attribute__((always_inline))
+
+/* The indexes run free and wrap at 2^32, the length masks them. */
+#define SPSC_RING_DEFINE(NAME, TYPE, LEN)                                      \
+_Static_assert((LEN) >= 2 && (LEN) <= 0x80000000UL && !((LEN) & ((LEN) - 1)), \
+               #NAME " length must be a power of 2");                          \
+                                                                               \
+typedef struct                                                                 \
+{                                                                              \
+    TYPE _elem[LEN];                                                           \
+    uint32_t _u32_head;             /* Written by the producer only. */        \
+    uint32_t _u32_tail;             /* Written by the consumer only. */        \
+} NAME;                                                                        \
+                                                                               \
+/* Empties the ring. Neither side may be using it meanwhile. */                \
+SPSC_RING_INLINE void NAME##Clear(NAME *pr)                                    \
+{                                                                              \
+    __atomic_store_n(&pr->_u32_tail, 0, __ATOMIC_RELAXED);                     \
+    __atomic_store_n(&pr->_u32_head, 0, __ATOMIC_RELEASE);                     \
+}                                                                              \
+                                                                               \
+/* Elements pending, exact on either side, a snapshot for anyone else. */     \
+SPSC_RING_INLINE uint32_t NAME##Count(const NAME *pr)                          \
+{                                                                              \
+    const uint32_t u32tail = __atomic_load_n(&pr->_u32_tail, __ATOMIC_ACQUIRE);\
+    return __atomic_load_n(&pr->_u32_head, __ATOMIC_ACQUIRE) - u32tail;        \
+}                                                                              \
+                                                                               \
+/* Producer. Returns true if the element is queued, false if it is full. */   \
+SPSC_RING_INLINE bool NAME##Push(NAME *pr, const TYPE *pe)                     \
+{                                                                              \
+    const uint32_t u32head = __atomic_load_n(&pr->_u32_head, __ATOMIC_RELAXED);\
+    if(u32head - __atomic_load_n(&pr->_u32_tail, __ATOMIC_ACQUIRE) >= (LEN))   \
+    {                                                                          \
+        return false;                                                          \
+    }                                                                          \
+    pr->_elem[u32head & ((LEN) - 1)] = *pe;                                    \
+    __atomic_store_n(&pr->_u32_head, u32head + 1, __ATOMIC_RELEASE);           \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* Consumer. Returns the oldest element, or NULL if the ring is empty. It     \
+   stays owned by the ring until NAME##Drop. */                                \
+SPSC_RING_INLINE const TYPE *NAME##Peek(NAME *pr)                              \
+{                                                                              \
+    const uint32_t u32tail = __atomic_load_n(&pr->_u32_tail, __ATOMIC_RELAXED);\
+    if(__atomic_load_n(&pr->_u32_head, __ATOMIC_ACQUIRE) == u32tail)           \
+    {                                                                          \
+        return NULL;                                                           \
+    }                                                                          \
+    return &pr->_elem[u32tail & ((LEN) - 1)];                                  \
+}                                                                              \
+                                                                               \
+/* Consumer. Frees the element NAME##Peek has returned. */                     \
+SPSC_RING_INLINE void NAME##Drop(NAME *pr)                                     \
+{                                                                              \
+    const uint32_t u32tail = __atomic_load_n(&pr->_u32_tail, __ATOMIC_RELAXED);\
+    __atomic_store_n(&pr->_u32_tail, u32tail + 1, __ATOMIC_RELEASE);           \
+}                                                                              \
+                                                                               \
+/* Consumer. Returns true if the oldest element is copied to *pe, false if the \
+   ring is empty. */                                                           \
+SPSC_RING_INLINE bool NAME##Pop(NAME *pr, TYPE *pe)                            \
+{                                                                              \
+    const TYPE *pelem = NAME##Peek(pr);                                        \
+    if(!pelem)                                                                 \
+    {                                                                          \
+        return false;                                                          \
+    }                                                                          \
+    *pe = *pelem;                                                              \
+    NAME##Drop(pr);                                                            \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* Consumer. Frees all the elements pushed so far. */                          \
+SPSC_RING_INLINE void NAME##DropAll(NAME *pr)                                  \
+{                                                                              \
+    __atomic_store_n(&pr->_u32_tail,                                           \
+                     __atomic_load_n(&pr->_u32_head, __ATOMIC_ACQUIRE),        \
+                     __ATOMIC_RELEASE);                                        \
+}
+
+#endif
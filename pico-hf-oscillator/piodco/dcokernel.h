@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  dcokernel.h - Hand scheduled inner loop of DCO worker V.2 for dco u-program.
+//
+//  DESCRIPTION
+//      One kernel per core type: Cortex-M0+ (RP2040), Cortex-M33 and Hazard3
+//  (RP2350). It defines the cycle budget of kernel per word and the offsets
+//  of PioDcoKernel which the assembly uses.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-hf-oscillator
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef DCOKERNEL_H_
+#define DCOKERNEL_H_
+
+/* The budget of kernel per word of dco u-program, CPU CLK cycles, with the
+   FIFO not full and zero wait state loads and stores. A word is 2 RF cycles,
+   so the core keeps up with the fundamental up to 2 * CLK / budget. With
+   PIODCO_KERNEL_PROFILE, PioDCOKernelProfile measures it on the core. */
+#if defined(PIODCO_NO_ASM_KERNEL)
+/* The C loop only. */
+#elif defined(__riscv)
+#define PIODCO_KERNEL_CYCLES_PER_WORD 15    /* Hazard3. */
+#elif defined(__ARM_ARCH_8M_MAIN__)
+#define PIODCO_KERNEL_CYCLES_PER_WORD 15    /* Cortex-M33. */
+#elif defined(__ARM_ARCH_6M__)
+#define PIODCO_KERNEL_CYCLES_PER_WORD 20    /* Cortex-M0+. */
+#endif
+
+/* Offsets of PioDcoKernel for assembly. */
+#define PIODCO_KERNEL_TXF       0
+#define PIODCO_KERNEL_FSTAT     4
+#define PIODCO_KERNEL_TXFULL    8
+#define PIODCO_KERNEL_PSEQ      12
+#define PIODCO_KERNEL_SEQ       16
+#define PIODCO_KERNEL_REG       20
+#define PIODCO_KERNEL_ACC       24
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+typedef struct
+{
+    volatile uint32_t *_pu32_txf;           /* TX FIFO of SM. */
+    const volatile uint32_t *_pu32_fstat;   /* FSTAT of PIO. */
+    uint32_t _u32_txfull;                   /* TXFULL bit of SM in FSTAT. */
+    const volatile uint32_t *_pu32_seq;     /* Publish counter of freq. */
+    uint32_t _u32_seq;                      /* The seq the cycles are of. */
+    int32_t _i32_reg;                       /* Cycles per PI less delay, 2^24. */
+    int32_t _i32_acc;                       /* PLL accumulated error. */
+} PioDcoKernel;
+
+#ifdef PIODCO_KERNEL_CYCLES_PER_WORD
+uint32_t PioDCOKernel2(PioDcoKernel *pk, uint32_t u32words);
+#ifdef PIODCO_KERNEL_PROFILE
+uint32_t PioDCOKernelProfile(void);
+#endif
+#endif
+
+#endif
+
+#endif
@@ -70,138 +70,2134 @@
 #include "piodco.h"
 
 #include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
 #include "../lib/assert.h"
+#include "../lib/utility.h"
+#if PICO_RP2350
+#include "hardware/structs/hstx_ctrl.h"
+#include "hardware/structs/hstx_fifo.h"
+#endif
 
 #include "build/dco2.pio.h"
+#include "dcokernel.h"
+#if defined(PIODCO_KERNEL_CYCLES_PER_WORD) && defined(PIODCO_KERNEL_PROFILE)
+#if defined(__riscv)
+#include "hardware/riscv.h"
+#else
+#include "hardware/structs/systick.h"
+#endif
+#endif
 
-volatile int32_t si32precise_cycles;
+#ifdef PIODCO_KERNEL_CYCLES_PER_WORD
+_Static_assert(offsetof(PioDcoKernel, _pu32_fstat) == PIODCO_KERNEL_FSTAT
+               && offsetof(PioDcoKernel, _u32_txfull) == PIODCO_KERNEL_TXFULL
+               && offsetof(PioDcoKernel, _pu32_seq) == PIODCO_KERNEL_PSEQ
+               && offsetof(PioDcoKernel, _u32_seq) == PIODCO_KERNEL_SEQ
+               && offsetof(PioDcoKernel, _i32_reg) == PIODCO_KERNEL_REG
+               && offsetof(PioDcoKernel, _i32_acc) == PIODCO_KERNEL_ACC, "dcokernel.h offsets");
+#endif
+
+static int si_dco_offset[2] = { -1, -1 };
+static int si_dco16_offset[2] = { -1, -1 };
+static int si_dcobits_offset[2] = { -1, -1 };
+static PioDco *spDMAdco[PIODCO_MAX_OUTPUTS] = { NULL };
+static int si_dma_irq_installed = NO;
+
+static uint32_t sui32_pattern[PIODCO_PATTERN_TONES][PIODCO_PATTERN_MAX_WORDS];
+static PioDco *spPatternDco = NULL;     /* The DCO the patterns are of. */
+
+/// @brief Calculates CPU CLK cycles per PI of the freq, scaled by 2^24.
+/// @param ui32_clkfreq_hz The CPU CLK freq [Hz].
+/// @param ui32_harmonic The harmonic N, the fundamental is generated at freq/N.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @return Cycles per PI, scaled by 2^24. It exceeds 32 bit below ~800 kHz.
+static int64_t PioDCOCalcCyclesPerPi64(uint32_t ui32_clkfreq_hz, uint32_t ui32_harmonic,
+                                       uint32_t ui32_frq_hz, int32_t i32_frq_millihz)
+{
+    /* RPix: Calculate an accurate value of phase increment of the freq 
+       per 1 tick of CPU clock, here 2^24 is scaling coefficient. */
+    const int64_t i64denominator = 2000LL * (int64_t)ui32_frq_hz + (int64_t)i32_frq_millihz;
+
+    /* The whole numerator exceeds 63 bits with a harmonic, so the scaling
+       goes to the remainder. */
+    const int64_t i64numerator = (int64_t)ui32_clkfreq_hz * (int64_t)ui32_harmonic * 1000LL;
+    return ((i64numerator / i64denominator) << 24)
+           + (((i64numerator % i64denominator) << 24) + (i64denominator>>1)) / i64denominator;
+}
+
+/// @brief Scales CPU CLK cycles per PI down to PIO CLK ones.
+/// @param i64_cycles Cycles per PI of CPU CLK, scaled by 2^24.
+/// @param u16_clkdiv PIO CLK divider.
+/// @return Cycles per PI of PIO CLK, scaled by 2^24.
+static __force_inline int32_t PioDCODivideCycles(int64_t i64_cycles, uint16_t u16_clkdiv)
+{
+    if(u16_clkdiv > 1)
+    {
+        return (int32_t)((i64_cycles + (u16_clkdiv >> 1)) / u16_clkdiv);
+    }
+
+    return (int32_t)i64_cycles;
+}
+
+/// @brief Calculates PIO CLK cycles per PI of the freq, scaled by 2^24, using
+/// @brief the current PIO CLK divider and harmonic of DCO.
+/// @param pdco Ptr to DCO context.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @return Cycles per PI, scaled by 2^24.
+static int32_t PioDCOCalcCyclesPerPi(const PioDco *pdco, uint32_t ui32_frq_hz, int32_t i32_frq_millihz)
+{
+    const int64_t i64cycles = PioDCOCalcCyclesPerPi64(pdco->_clkfreq_hz, pdco->_u8_harmonic_n,
+                                                      ui32_frq_hz, i32_frq_millihz);
+    return PioDCODivideCycles(i64cycles, pdco->_u16_clkdiv);
+}
+
+/// @brief Configures SM of DCO for its current u-program. The SM is disabled.
+/// @param pdco Ptr to DCO context.
+static void PioDCOConfigSM(PioDco *pdco)
+{
+    int offset = pdco->_offset;
+    if(eDCOPROG_DCO16 == pdco->_program)
+    {
+        offset = pdco->_offset16;
+        pdco->_pio_sm = dco16_program_get_default_config(offset);
+    }
+    else if(eDCOPROG_BITS == pdco->_program)
+    {
+        offset = pdco->_offset_bits;
+        pdco->_pio_sm = dcobits_program_get_default_config(offset);
+        sm_config_set_out_pins(&pdco->_pio_sm, pdco->_gpio, 1);
+    }
+    else
+    {
+        pdco->_pio_sm = dco_program_get_default_config(offset);
+    }
+
+    sm_config_set_out_shift(&pdco->_pio_sm, true, true, 32);           // Autopull.
+    sm_config_set_fifo_join(&pdco->_pio_sm, PIO_FIFO_JOIN_TX);
+    sm_config_set_set_pins(&pdco->_pio_sm, pdco->_gpio, pdco->_u8_pins);
+    sm_config_set_clkdiv_int_frac(&pdco->_pio_sm, pdco->_u16_clkdiv, 0);
+    
+    pio_sm_init(pdco->_pio, pdco->_ism, offset, &pdco->_pio_sm);
+}
 
 /// @brief Initializes DCO context and prepares PIO hardware.
 /// @param pdco Ptr to DCO context.
-/// @param gpio The GPIO of DCO output.
-/// @param cpuclkhz The system CPU clock freq., Hz.
-/// @return 0 if OK.
-int PioDCOInit(PioDco *pdco, int gpio)
+/// @param gpio The GPIO of DCO output.
+/// @return 0 if OK. -1 no free SM.
+/// @remark It might be called for up to PIODCO_MAX_OUTPUTS contexts on separate
+/// @remark GPIOs, they share the PIO program and use an SM each.
+int PioDCOInit(PioDco *pdco, int gpio)
+{
+    assert_(pdco);
+  
+    memset(pdco, 0, sizeof(PioDco));
+
+    pdco->_clkfreq_hz = clock_get_hz(clk_sys);
+    pdco->_pio = pio0;
+    pdco->_gpio = gpio;
+    pdco->_u8_pins = 1;
+    pdco->_ism = pio_claim_unused_sm(pdco->_pio, false);
+    if(pdco->_ism < 0)
+    {
+        return -1;
+    }
+
+    const uint ipio = pio_get_index(pdco->_pio);
+    if(si_dco_offset[ipio] < 0)
+    {
+        si_dco_offset[ipio] = pio_add_program(pdco->_pio, &dco_program);
+    }
+    pdco->_offset = si_dco_offset[ipio];
+    if(si_dco16_offset[ipio] < 0)
+    {
+        si_dco16_offset[ipio] = pio_add_program(pdco->_pio, &dco16_program);
+    }
+    pdco->_offset16 = si_dco16_offset[ipio];
+    if(si_dcobits_offset[ipio] < 0)
+    {
+        si_dcobits_offset[ipio] = pio_add_program(pdco->_pio, &dcobits_program);
+    }
+    pdco->_offset_bits = si_dcobits_offset[ipio];
+    pdco->_program = eDCOPROG_DCO;
+    pdco->_u16_clkdiv = 1;
+    pdco->_u8_harmonic_n = 1;
+    pdco->_u16_duty_permille = 500;
+    pdco->_env_gpio = pdco->_env_dma_chan = pdco->_env_dma_timer = -1;
+    pdco->_u8_fifo_min_level = pdco->_u8_fifo_min_ever = PIODCO_FIFO_DEPTH;
+    pdco->_u8_fifo_depth = PIODCO_FIFO_DEPTH;
+    pdco->_dma_chan[0] = pdco->_dma_chan[1] = pdco->_dma_chan[2] = -1;
+    pdco->_u8_mash_order = 1;
+
+    gpio_init(pdco->_gpio);
+    pio_gpio_init(pdco->_pio, pdco->_gpio);
+
+    dco_program_init(pdco->_pio, pdco->_ism, pdco->_offset, pdco->_gpio);
+    PioDCOConfigSM(pdco);
+
+    return 0;
+}
+
+/// @brief Switches SM of DCO to another u-program, keeping its enable state.
+/// @param pdco Ptr to DCO context.
+/// @param eprog The u-program.
+/// @attention The FIFO contents are lost, it is for the worker to call.
+static void PioDCOSetProgram(PioDco *pdco, enum PioDcoProgram eprog)
+{
+    if(eprog == pdco->_program)
+    {
+        return;
+    }
+
+    const bool is_enabled = pdco->_pio->ctrl & (1U << pdco->_ism);
+    pio_sm_set_enabled(pdco->_pio, pdco->_ism, false);
+
+    pdco->_program = eprog;
+    PioDCOConfigSM(pdco);
+    pdco->_pio->fdebug = 1U << (PIO_FDEBUG_TXSTALL_LSB + pdco->_ism);
+
+    pio_sm_set_enabled(pdco->_pio, pdco->_ism, is_enabled);
+}
+
+/// @brief Calculates the highest fundamental MASH of an order runs at: the
+/// @brief word of MASH goes down to n-span+1, it is to stay above zero.
+/// @param ui32_clkfreq_hz The CPU CLK freq [Hz].
+/// @param order The order of MASH, 1..3.
+/// @return The freq [Hz], below CLK/PIODCO_HARMONIC_CLK_RATIO. One cycle is
+/// @return spare for the rounding of harmonic.
+static uint32_t PioDCOMASHMaxFundamental(uint32_t ui32_clkfreq_hz, int order)
+{
+    return ui32_clkfreq_hz / (2 * (PIOASM_DELAY_CYCLES + PIODCO_MASH_SPAN(order) + 1));
+}
+
+/// @brief Chooses the harmonic of a freq: the lowest odd one which keeps the
+/// @brief fundamental below the limit, unless set explicitly.
+/// @param u8_harmonic The harmonic set, 0 is auto.
+/// @param ui32_max_fundamental_hz The limit of fundamental [Hz].
+/// @param ui32_frq_hz The freq [Hz].
+/// @return The harmonic, 1..PIODCO_MAX_HARMONIC.
+static uint8_t PioDCOCalcHarmonic(uint8_t u8_harmonic, uint32_t ui32_max_fundamental_hz,
+                                  uint32_t ui32_frq_hz)
+{
+    if(u8_harmonic)
+    {
+        return u8_harmonic;
+    }
+
+    uint8_t u8harmonic = 1;
+    while(u8harmonic < PIODCO_MAX_HARMONIC && ui32_frq_hz / u8harmonic > ui32_max_fundamental_hz)
+    {
+        u8harmonic += 2;
+    }
+
+    return u8harmonic;
+}
+
+/// @brief Lowers MASH order until the word stays above zero at the freq.
+/// @param i32_cycles_per_pi PIO CLK cycles per PI of the freq, scaled by 2^24.
+/// @param order The order of MASH set, 1..3.
+/// @return The order MASH runs at the freq. The order 1 word might still be
+/// @return zero if the harmonic is too low, the worker clamps it then.
+static uint8_t PioDCOFitMASHOrder(int32_t i32_cycles_per_pi, int order)
+{
+    const int32_t i32n = (i32_cycles_per_pi >> 24) - PIOASM_DELAY_CYCLES;
+    while(order > 1 && i32n < PIODCO_MASH_SPAN(order))
+    {
+        --order;
+    }
+
+    return order;
+}
+
+/// @brief Calculates the freq descriptor of Fout = ui32_frq_hz + ui32_frq_millihz * 1e-3,
+/// @brief with the harmonic and PIO CLK divider of DCO for it.
+/// @param pdco Ptr to DCO context.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param ui32_frq_millihz The `fine` part of frequency [mHz].
+/// @param pdesc Ptr to the descriptor to fill.
+/// @return Cycles per PI of the freq, scaled by 2^24.
+/// @remark DCO is not changed, the harmonic and divider take effect when the
+/// @remark descriptor is published, so a table might be made while running.
+/// @remark In harmonic mode the freq is the on-air one, the fundamental is
+/// @remark generated at Fout/N, so the tone steps and GPS correction which
+/// @remark are the part of Fout get scaled by 1/N as well.
+/// @remark On LF and MF the cycles per PI don't fit 2^24 scaled int32, so the
+/// @remark PIO CLK is divided by an integer instead. HF path is not affected.
+static int32_t PioDCOCalcFreqDesc(const PioDco *pdco, uint32_t ui32_frq_hz, int32_t ui32_frq_millihz,
+                                  PioDcoFreqDesc *pdesc)
+{
+    const uint32_t ui32clk_hz = pdco->_clkfreq_hz ? pdco->_clkfreq_hz : clock_get_hz(clk_sys);
+
+    /* The lowest odd harmonic which keeps the fundamental well below the
+       limit of DCO, unless set explicitly. */
+    const int is_mash = eDCOENGINE_MASH == pdco->_engine;
+    uint32_t ui32max_fundamental_hz = 
+        (pdco->_u32_hstx_bit_hz ? pdco->_u32_hstx_bit_hz : ui32clk_hz) / PIODCO_HARMONIC_CLK_RATIO;
+    if(pdco->_pgroup)
+    {
+        /* The worker of phase group sends each word to n SMs. */
+        ui32max_fundamental_hz = ui32clk_hz / (PIODCO_GROUP_CLK_RATIO * pdco->_pgroup->_u8_group_n);
+    }
+    if(is_mash)
+    {
+        /* A higher harmonic keeps the order set where it can. */
+        ui32max_fundamental_hz = PioDCOMASHMaxFundamental(ui32clk_hz, pdco->_u8_mash_order);
+    }
+    const uint8_t u8harmonic = PioDCOCalcHarmonic(pdco->_u8_harmonic, ui32max_fundamental_hz, ui32_frq_hz);
+
+    const int64_t i64cycles = PioDCOCalcCyclesPerPi64(ui32clk_hz, u8harmonic,
+                                                      ui32_frq_hz, ui32_frq_millihz);
+    const uint16_t u16clkdiv = (i64cycles + INT32_MAX - 1) / INT32_MAX;
+    const int32_t i32cycles_per_pi = PioDCODivideCycles(i64cycles, u16clkdiv);
+
+    /* The finer dco16 needs twice the word rate, so it is for the low freqs
+       of CPU engine only. A phase group runs dco in lockstep. */
+    const bool is_dco16 = eDCOENGINE_CPU == pdco->_engine && !pdco->_pgroup
+        && ui32_frq_hz / u8harmonic <= ui32clk_hz / PIODCO_DCO16_CLK_RATIO;
+    const int32_t i32delay_cycles = is_dco16 ? PIOASM_DCO16_DELAY_CYCLES : PIOASM_DELAY_CYCLES;
+
+    /* dco16 times the low and the high halves separately, so the period is
+       split according to the duty. */
+    int32_t i32space = i32cycles_per_pi, i32mark = i32cycles_per_pi;
+    if(is_dco16 && 500 != pdco->_u16_duty_permille)
+    {
+        const int64_t i64period = 2LL * i32cycles_per_pi;
+        i32mark = (int32_t)((i64period * pdco->_u16_duty_permille + 500LL) / 1000LL);
+        i32space = (int32_t)(i64period - i32mark);
+    }
+
+    memset(pdesc, 0, sizeof(PioDcoFreqDesc));
+    pdesc->_i32_precise_cycles = i32space - (i32delay_cycles<<24);
+    pdesc->_i32_precise_mark = i32mark - (i32delay_cycles<<24);
+    pdesc->_ui32_frq_hz = ui32_frq_hz;
+    pdesc->_i32_frq_millihz = ui32_frq_millihz;
+    pdesc->_u8_program = is_dco16 ? eDCOPROG_DCO16 : eDCOPROG_DCO;
+    pdesc->_u8_harmonic_n = u8harmonic;
+    pdesc->_u16_clkdiv = u16clkdiv;
+    pdesc->_u8_mash_order = is_mash ? PioDCOFitMASHOrder(i32cycles_per_pi, pdco->_u8_mash_order) : 0;
+
+    return i32cycles_per_pi;
+}
+
+/// @brief Publishes a freq descriptor to the worker with the current key
+/// @brief state and phase shifts. The harmonic and PIO CLK divider of the
+/// @brief descriptor are applied to DCO.
+/// @param pdco Ptr to DCO context.
+/// @param pdesc Ptr to the descriptor of freq.
+/// @param i32_cycles_per_pi Cycles per PI of the freq, scaled by 2^24.
+static __force_inline void PioDCOPublishFreqDesc(PioDco *pdco, const PioDcoFreqDesc *pdesc,
+                                                 int32_t i32_cycles_per_pi)
+{
+    /* Fill the descriptor the worker doesn't use, then flip to it. Interrupts
+       are off since both ISR and thread code of core0 might call this. */
+    const uint32_t u32irq = save_and_disable_interrupts();
+    const uint32_t u32seq = pdco->_u32_freq_seq + 1;
+    PioDcoFreqDesc *pnext = &pdco->_freq[u32seq & 1];
+    *pnext = *pdesc;
+    pnext->_u8_key_up = pdco->_u8_key_up;
+    pnext->_i32_phase_total = pdco->_i32_phase_total;
+    pdco->_frq_cycles_per_pi = i32_cycles_per_pi;
+    pdco->_ui32_frq_hz = pdesc->_ui32_frq_hz;
+    pdco->_ui32_frq_millihz = pdesc->_i32_frq_millihz;
+    pdco->_u8_harmonic_n = pdesc->_u8_harmonic_n;
+    if(pdesc->_u16_clkdiv != pdco->_u16_clkdiv)
+    {
+        pdco->_u16_clkdiv = pdesc->_u16_clkdiv;
+        if(pdco->_pio)
+        {
+            pio_sm_set_clkdiv_int_frac(pdco->_pio, pdco->_ism, pdesc->_u16_clkdiv, 0);
+        }
+    }
+    pdco->_u32_published_us = timer_hw->timerawl;
+    __dmb();
+    pdco->_u32_freq_seq = u32seq;
+    restore_interrupts(u32irq);
+}
+
+/// @brief Sets DCO working frequency in Hz: Fout = ui32_frq_hz + ui32_frq_millihz * 1e-3.
+/// @param pdco Ptr to DCO context.
+/// @param i32_frq_hz The `coarse` part of frequency [Hz]. Might be negative.
+/// @param ui32_frq_millihz The `fine` part of frequency [Hz].
+/// @return 0 if OK. -1 invalid freq.
+/// @attention The func can be called while DCO running.
+/// @remark It does several 64-bit divisions, the tone table is for ISRs.
+int PioDCOSetFreq(PioDco *pdco, uint32_t ui32_frq_hz, int32_t ui32_frq_millihz)
+{
+    assert_(pdco);
+
+    PioDcoFreqDesc desc;
+    const int32_t i32cycles_per_pi = PioDCOCalcFreqDesc(pdco, ui32_frq_hz, ui32_frq_millihz, &desc);
+    PioDCOPublishFreqDesc(pdco, &desc, i32cycles_per_pi);
+
+    return 0;
+}
+
+/// @brief Builds the tone table of a transmission: the freq descriptors of
+/// @brief Fout + i * step, GPS correction applied, so selecting a tone is
+/// @brief a copy and a flip of the descriptor without any divisions.
+/// @param pdco Ptr to DCO context.
+/// @param ptt Ptr to the table to build.
+/// @param ui32_frq_hz The freq of tone 0 [Hz].
+/// @param i32_step_millihz The tone spacing [mHz].
+/// @remark It is to be rebuilt when PioDCOToneTableIsStale says so. DCO is
+/// @remark not changed until a tone is selected.
+void PioDCOToneTableBuild(const PioDco *pdco, PioDcoToneTable *ptt, uint32_t ui32_frq_hz, 
+                          int32_t i32_step_millihz)
+{
+    assert_(pdco);
+    assert_(ptt);
+
+    ptt->_i64_ppb = pdco->_pGPStime ? pdco->_pGPStime->_time_data._i32_freq_shift_ppb : 0;
+    const int32_t i32_compensation_millis = 
+        PioDCOGetFreqShiftMilliHertz(pdco, (uint64_t)(ui32_frq_hz * 1000LL));
+
+    for(int i = 0; i < PIODCO_TONE_TABLE_LEN; ++i)
+    {
+        ptt->_i32_cycles_per_pi[i] = 
+            PioDCOCalcFreqDesc(pdco, ui32_frq_hz, i * i32_step_millihz - 2 * i32_compensation_millis,
+                               &ptt->_desc[i]);
+    }
+}
+
+/// @brief Checks whether GPS correction has changed since the table was built.
+/// @param pdco Ptr to DCO context.
+/// @param ptt Ptr to the table.
+/// @return Non-zero if the table is to be rebuilt.
+int PioDCOToneTableIsStale(const PioDco *pdco, const PioDcoToneTable *ptt)
+{
+    assert_(pdco);
+    assert_(ptt);
+
+    return pdco->_pGPStime && pdco->_pGPStime->_time_data._i32_freq_shift_ppb
+        && pdco->_pGPStime->_time_data._i32_freq_shift_ppb != ptt->_i64_ppb;
+}
+
+/// @brief Sets DCO working frequency to a tone of the table.
+/// @param pdco Ptr to DCO context.
+/// @param ptt Ptr to the table.
+/// @param itone The tone, 0..PIODCO_TONE_TABLE_LEN-1.
+/// @remark It is for ISRs: no divisions, about 50 CPU cycles.
+void RAM (PioDCOToneSelect)(PioDco *pdco, const PioDcoToneTable *ptt, int itone)
+{
+    itone &= PIODCO_TONE_TABLE_LEN - 1;
+    PioDCOPublishFreqDesc(pdco, &ptt->_desc[itone], ptt->_i32_cycles_per_pi[itone]);
+}
+
+/// @brief Reads the freq descriptor published last. Lock-free: the reader
+/// @brief retries if the writer has flipped twice while it was reading.
+/// @param pdco Ptr to DCO context.
+/// @param pdesc Ptr to the copy of descriptor.
+/// @return The seq of the descriptor.
+static __force_inline uint32_t PioDCOReadFreqDesc(const PioDco *pdco, PioDcoFreqDesc *pdesc)
+{
+    uint32_t u32seq;
+    do
+    {
+        u32seq = pdco->_u32_freq_seq;
+        __dmb();
+        *pdesc = pdco->_freq[u32seq & 1];
+        __dmb();
+    } while(u32seq != pdco->_u32_freq_seq);
+
+    return u32seq;
+}
+
+/// @brief Obtains a consistent copy of the freq descriptor published last.
+/// @param pdco Ptr to DCO context.
+/// @param pdesc Ptr to the copy of descriptor.
+/// @return The seq of the descriptor.
+uint32_t PioDCOGetFreqDesc(const PioDco *pdco, PioDcoFreqDesc *pdesc)
+{
+    assert_(pdco);
+    assert_(pdesc);
+
+    return PioDCOReadFreqDesc(pdco, pdesc);
+}
+
+/// @brief Checks whether a new freq has been published and loads it if so.
+/// @brief The word index and the time it took effect at are published back.
+/// @param pDCO Ptr to DCO context.
+/// @param pu32seq Ptr to the seq the worker runs on.
+/// @param pi32cycles Ptr to the cycles per word the worker uses.
+/// @param pi32mark Ptr to the cycles of high half of dco16 worker, or NULL.
+/// @param pi32acc Ptr to the PLL error of worker the phase shifts go to, or NULL.
+/// @param u32word The index of the next word the worker sends.
+/// @return Non-zero if the new freq needs another u-program than SM runs, or
+/// @return another MASH order than the worker runs.
+static __force_inline int PioDCOPollFreq(PioDco *pDCO, uint32_t *pu32seq, int32_t *pi32cycles,
+                                         int32_t *pi32mark, int32_t *pi32acc, uint32_t u32word)
+{
+    if(__builtin_expect(pDCO->_u32_freq_seq == *pu32seq, 1))
+    {
+        return 0;
+    }
+
+    PioDcoFreqDesc desc;
+    *pu32seq = PioDCOReadFreqDesc(pDCO, &desc);
+
+    /* Keyed up: the SM drains FIFO and stalls on `out` after a whole word,
+       so the output stops low on a whole cycle. */
+    while(desc._u8_key_up)
+    {
+        while(pDCO->_u32_freq_seq == *pu32seq)
+        {
+            tight_loop_contents();
+        }
+        *pu32seq = PioDCOReadFreqDesc(pDCO, &desc);
+        pDCO->_pio->fdebug = 1U << (PIO_FDEBUG_TXSTALL_LSB + pDCO->_ism);
+    }
+
+    *pi32cycles = desc._i32_precise_cycles;
+    if(pi32mark)
+    {
+        *pi32mark = desc._i32_precise_mark;
+    }
+
+    /* The phase shifts published since the last poll delay the next word:
+       the PLL sees a lag it makes up for at once. */
+    const int32_t i32phase = desc._i32_phase_total - pDCO->_i32_phase_applied;
+    pDCO->_i32_phase_applied = desc._i32_phase_total;
+    if(pi32acc && desc._u8_program == pDCO->_program)
+    {
+        *pi32acc -= eDCOPROG_DCO16 == desc._u8_program ? i32phase << 2 : i32phase;
+    }
+
+    /* The word SM runs completes, so the waveform stays continuous, only
+       the stale ones queued go. */
+    if(pDCO->_u8_fifo_flush)
+    {
+        pio_sm_clear_fifos(pDCO->_pio, pDCO->_ism);
+    }
+
+    pDCO->_u32_applied_word = u32word;
+    pDCO->_u32_applied_us = timer_hw->timerawl;
+    pDCO->_u32_applied_seq = *pu32seq;
+
+    return desc._u8_program != pDCO->_program || desc._u8_mash_order != pDCO->_u8_mash_run;
+}
+
+/// @brief Samples the TX FIFO of SM: counts the underruns and overflows flagged
+/// @brief by PIO since the last sample, and keeps the lowest FIFO level.
+/// @param pDCO Ptr to DCO context.
+/// @param u32word The index of the next word the worker sends.
+/// @remark It samples every PIODCO_FIFO_SAMPLE_WORDS words, so a count is of
+/// @remark sample periods with at least one underrun, not of missing words.
+static __force_inline void PioDCOSampleFifo(PioDco *pDCO, uint32_t u32word)
+{
+    if(__builtin_expect(u32word & (PIODCO_FIFO_SAMPLE_WORDS - 1), 1))
+    {
+        return;
+    }
+
+    const uint32_t u32stall = 1U << (PIO_FDEBUG_TXSTALL_LSB + pDCO->_ism);
+    const uint32_t u32over = 1U << (PIO_FDEBUG_TXOVER_LSB + pDCO->_ism);
+    const uint32_t u32fdebug = pDCO->_pio->fdebug & (u32stall | u32over);
+    if(u32fdebug)
+    {
+        pDCO->_pio->fdebug = u32fdebug;     /* Write 1 to clear. */
+        if(u32fdebug & u32stall)
+        {
+            ++pDCO->_u32_fifo_stalls;
+        }
+        if(u32fdebug & u32over)
+        {
+            ++pDCO->_u32_fifo_overs;
+        }
+    }
+
+    const uint8_t u8level = pio_sm_get_tx_fifo_level(pDCO->_pio, pDCO->_ism);
+    if(pDCO->_u8_fifo_reset || u8level < pDCO->_u8_fifo_min_level)
+    {
+        pDCO->_u8_fifo_min_level = u8level;
+        pDCO->_u8_fifo_reset = NO;
+    }
+    if(u8level < pDCO->_u8_fifo_min_ever)
+    {
+        pDCO->_u8_fifo_min_ever = u8level;
+    }
+}
+
+/// @brief Starts the per transmission FIFO telemetry. The lifetime counters
+/// @brief go on, the ones of TX are the difference to their snapshot.
+/// @param pdco Ptr to DCO context.
+/// @remark The stall flag of SM idling before TX is dropped.
+void PioDCOFifoStatsStart(PioDco *pdco)
+{
+    assert_(pdco);
+
+    pdco->_pio->fdebug = 1U << (PIO_FDEBUG_TXSTALL_LSB + pdco->_ism);
+    pdco->_u32_fifo_stalls_tx0 = pdco->_u32_fifo_stalls;
+    pdco->_u32_fifo_overs_tx0 = pdco->_u32_fifo_overs;
+    pdco->_u8_fifo_min_level = PIODCO_FIFO_DEPTH;
+    pdco->_u8_fifo_reset = YES;
+}
+
+/// @brief Obtains the frequency shift [milliHz] which is calculated for a given frequency.
+/// @param pdco Ptr to Context.
+/// @param u64_desired_frq_millihz The frequency for which we want to calculate correction.
+/// @return The value of correction we need to subtract from desired freq. to compensate
+/// @return Pico's reference clock shift. 2854974.
+int32_t PioDCOGetFreqShiftMilliHertz(const PioDco *pdco, uint64_t u64_desired_frq_millihz)
+{
+    assert_(pdco);
+    if(!pdco->_pGPStime)
+    {
+        return 0U;
+    }
+
+    static int64_t i64_last_correction = 0;
+    const int64_t dt = pdco->_pGPStime->_time_data._i32_freq_shift_ppb; /* Parts per billion. */
+    if(dt)
+    {
+        i64_last_correction = dt;
+    }
+
+    int32_t i32ret_millis;
+    if(i64_last_correction)
+    {
+        /* Hz rather than kHz resolution, it matters on LF and MF. */
+        int64_t i64corr_coeff = (u64_desired_frq_millihz + 500LL) / 1000LL;
+        i32ret_millis = (i64_last_correction * i64corr_coeff + 500000000LL) / 1000000000LL;
+
+        return i32ret_millis;
+    }
+
+    return 0U;
+}
+
+/// @brief Publishes the current freq descriptor again with the key state
+/// @brief and the phase shifts.
+/// @param pdco Ptr to DCO context.
+static void PioDCORepublish(PioDco *pdco)
+{
+    const uint32_t u32irq = save_and_disable_interrupts();
+    const uint32_t u32seq = pdco->_u32_freq_seq + 1;
+    pdco->_freq[u32seq & 1] = pdco->_freq[pdco->_u32_freq_seq & 1];
+    pdco->_freq[u32seq & 1]._u8_key_up = pdco->_u8_key_up;
+    pdco->_freq[u32seq & 1]._i32_phase_total = pdco->_i32_phase_total;
+    pdco->_u32_published_us = timer_hw->timerawl;
+    __dmb();
+    pdco->_u32_freq_seq = u32seq;
+    restore_interrupts(u32irq);
+}
+
+/// @brief Starts the DCO.
+/// @param pdco Ptr to DCO context.
+/// @remark The SMs of phase group are started by its worker, in lockstep.
+void PioDCOStart(PioDco *pdco)
+{
+    assert_(pdco);
+    if(pdco->_u8_group_n)
+    {
+        pdco->_is_enabled = YES;
+        PioDCORepublish(pdco);
+        return;
+    }
+#if PICO_RP2350
+    if(pdco->_u32_hstx_bit_hz)
+    {
+        hw_set_bits(&hstx_ctrl_hw->csr, HSTX_CTRL_CSR_EN_BITS);
+    }
+    else
+#endif
+    pio_sm_set_enabled(pdco->_pio, pdco->_ism, true);
+
+    pdco->_is_enabled = YES;
+}
+
+/// @brief Stops the DCO.
+/// @param pdco Ptr to DCO context.
+/// @remark The SMs of phase group are stopped by its worker.
+void PioDCOStop(PioDco *pdco)
+{
+    assert_(pdco);
+    if(pdco->_u8_group_n)
+    {
+        pdco->_is_enabled = NO;
+        PioDCORepublish(pdco);
+        return;
+    }
+#if PICO_RP2350
+    if(pdco->_u32_hstx_bit_hz)
+    {
+        hw_clear_bits(&hstx_ctrl_hw->csr, HSTX_CTRL_CSR_EN_BITS);
+    }
+    else
+#endif
+    pio_sm_set_enabled(pdco->_pio, pdco->_ism, false);
+
+    pdco->_is_enabled = NO;
+}
+
+static uint32_t su32_env_rise[PIODCO_ENV_STEPS];    /* PWM CC of ramp up. */
+static uint32_t su32_env_fall[PIODCO_ENV_STEPS];    /* PWM CC of ramp down. */
+
+/// @brief Paces the envelope DMA so that a ramp lasts PIODCO_ENV_RAMP_US at
+/// @brief the current CPU CLK.
+/// @param pdco Ptr to DCO context.
+static void PioDCOEnvelopeSetRate(PioDco *pdco)
+{
+    dma_timer_set_fraction(pdco->_env_dma_timer, 1, 
+                           clock_get_hz(clk_sys) / (PIODCO_ENV_STEPS * 1000000UL / PIODCO_ENV_RAMP_US));
+}
+
+/// @brief Initializes the keying envelope: a PWM pin which is to drive PA bias
+/// @brief through an RC filter. The raised cosine ramps are sent to PWM by
+/// @brief DMA paced by a DMA timer, so no CPU is involved while keying.
+/// @param pdco Ptr to DCO context.
+/// @param gpio The GPIO of envelope PWM output.
+/// @return 0 if OK.
+int PioDCOEnvelopeInit(PioDco *pdco, int gpio)
+{
+    assert_(pdco);
+
+    /* Raised cosine, sin^2 of quarter-period. Level of both PWM channels
+       of the slice, since narrow DMA writes are replicated anyway. */
+    for(int i = 0; i < PIODCO_ENV_STEPS; ++i)
+    {
+        const float fs = sinf(1.5707963f * (float)(i + 1) / (float)PIODCO_ENV_STEPS);
+        const uint32_t u32level = (uint32_t)(fs * fs * (float)PIODCO_ENV_PWM_WRAP + 0.5f);
+        su32_env_rise[i] = u32level | (u32level << 16);
+        su32_env_fall[PIODCO_ENV_STEPS - 1 - i] = i ? su32_env_rise[i - 1] : 0;
+    }
+
+    pdco->_env_gpio = gpio;
+    gpio_set_function(gpio, GPIO_FUNC_PWM);
+    const uint slice = pwm_gpio_to_slice_num(gpio);
+    pwm_config pc = pwm_get_default_config();
+    pwm_config_set_wrap(&pc, PIODCO_ENV_PWM_WRAP);
+    pwm_init(slice, &pc, true);
+    pwm_set_gpio_level(gpio, 0);
+
+    pdco->_env_dma_timer = dma_claim_unused_timer(true);
+    PioDCOEnvelopeSetRate(pdco);
+
+    pdco->_env_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(pdco->_env_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, dma_get_timer_dreq(pdco->_env_dma_timer));
+    dma_channel_configure(pdco->_env_dma_chan, &c, &pwm_hw->slice[slice].cc,
+                          su32_env_rise, PIODCO_ENV_STEPS, false);
+
+    return 0;
+}
+
+/// @brief Releases the SM and DMA channels of the worker, once the core it
+/// @brief runs on has been reset. It is for the low power mode between
+/// @brief transmissions; the worker may be run again after PioDCOSetClock.
+/// @param pdco Ptr to DCO context.
+/// @remark The freq and the envelope are kept. The SM and its GPIO are back
+/// @remark to the dco u-program of PioDCOInit, so that the engine might be
+/// @remark changed for the next run.
+void PioDCOSuspend(PioDco *pdco)
+{
+    assert_(pdco);
+
+    PioDCOStop(pdco);
+    for(int i = 0; i < pdco->_u8_group_n; ++i)
+    {
+        pio_sm_set_enabled(pdco->_pio, pdco->_apgroup[i]->_ism, false);
+    }
+    pio_sm_clear_fifos(pdco->_pio, pdco->_ism);
+
+    /* All at once, so that none restarts another by chaining. */
+    uint32_t u32mask = 0;
+    for(int i = 0; i < PIODCO_DMA_CHANS; ++i)
+    {
+        if(pdco->_dma_chan[i] >= 0)
+        {
+            dma_channel_set_irq1_enabled(pdco->_dma_chan[i], false);
+            u32mask |= 1U << pdco->_dma_chan[i];
+        }
+    }
+    dma_hw->abort = u32mask;
+    while(dma_hw->abort & u32mask)
+    {
+        tight_loop_contents();
+    }
+    for(int i = 0; i < PIODCO_DMA_CHANS; ++i)
+    {
+        if(pdco->_dma_chan[i] >= 0)
+        {
+            dma_channel_unclaim(pdco->_dma_chan[i]);
+            pdco->_dma_chan[i] = -1;
+        }
+    }
+
+    for(int i = 0; i < PIODCO_MAX_OUTPUTS; ++i)
+    {
+        if(pdco == spDMAdco[i])
+        {
+            spDMAdco[i] = NULL;
+        }
+    }
+    pdco->_pu32_pattern_ctrl = NULL;
+    if(pdco == spPatternDco)
+    {
+        spPatternDco = NULL;
+    }
+
+    PioDCOSetProgram(pdco, eDCOPROG_DCO);
+#if PICO_RP2350
+    if(pdco->_u32_hstx_bit_hz)
+    {
+        hstx_ctrl_hw->csr = 0;
+        pio_gpio_init(pdco->_pio, pdco->_gpio);
+    }
+#endif
+}
+
+/// @brief Recalculates the constants of DCO for the current CPU CLK, which has
+/// @brief been changed since PioDCOInit, and republishes the working freq.
+/// @param pdco Ptr to DCO context.
+void PioDCOSetClock(PioDco *pdco)
+{
+    assert_(pdco);
+
+    pdco->_clkfreq_hz = clock_get_hz(clk_sys);
+#if PICO_RP2350
+    if(pdco->_u32_hstx_bit_hz)
+    {
+        pdco->_u32_hstx_bit_hz = 2U * clock_get_hz(clk_hstx);
+    }
+#endif
+    if(pdco->_env_dma_timer >= 0)
+    {
+        PioDCOEnvelopeSetRate(pdco);
+    }
+
+    PioDCOSetFreq(pdco, pdco->_ui32_frq_hz, pdco->_ui32_frq_millihz);
+}
+
+/// @brief Keys up at the end of the fall ramp of envelope.
+static int64_t PioDCOKeyUpAlarm(alarm_id_t id, void *user_data)
+{
+    PioDco *pdco = (PioDco *)user_data;
+
+    pdco->_env_alarm = 0;
+    pdco->_u8_key_up = YES;
+    PioDCORepublish(pdco);
+
+    return 0;
+}
+
+/// @brief Keys the DCO down: the worker resumes feeding SM and the envelope
+/// @brief (if any) ramps up.
+/// @param pdco Ptr to DCO context.
+/// @remark The SM is enabled if it isn't.
+void PioDCOKeyDown(PioDco *pdco)
+{
+    assert_(pdco);
+
+    if(pdco->_env_alarm > 0)
+    {
+        cancel_alarm(pdco->_env_alarm);
+        pdco->_env_alarm = 0;
+    }
+
+    if(pdco->_u8_key_up)
+    {
+        pdco->_u8_key_up = NO;
+        PioDCORepublish(pdco);
+    }
+    if(!pdco->_is_enabled)
+    {
+        PioDCOStart(pdco);
+    }
+
+    if(pdco->_env_gpio >= 0)
+    {
+        dma_channel_abort(pdco->_env_dma_chan);
+        dma_channel_transfer_from_buffer_now(pdco->_env_dma_chan, su32_env_rise, PIODCO_ENV_STEPS);
+    }
+}
+
+/// @brief Keys the DCO up gracefully: the envelope (if any) ramps down, then
+/// @brief the worker stops feeding SM so it stalls low on a whole cycle. Unlike
+/// @brief PioDCOStop the SM is not stopped in the middle of a cycle.
+/// @param pdco Ptr to DCO context.
+/// @attention The DMA and pattern engines can't stall, they are stopped. The
+/// @attention worker of several DCOs would stall all of them, so it isn't for it.
+void PioDCOKeyUp(PioDco *pdco)
+{
+    assert_(pdco);
+
+    if(pdco->_u8_key_up || pdco->_env_alarm > 0)
+    {
+        return;
+    }
+
+    if(eDCOENGINE_DMA == pdco->_engine || eDCOENGINE_PATTERN == pdco->_engine
+       || eDCOENGINE_BITSTREAM == pdco->_engine)
+    {
+        PioDCOStop(pdco);
+        return;
+    }
+
+    if(pdco->_env_gpio >= 0)
+    {
+        dma_channel_abort(pdco->_env_dma_chan);
+        dma_channel_transfer_from_buffer_now(pdco->_env_dma_chan, su32_env_fall, PIODCO_ENV_STEPS);
+        pdco->_env_alarm = add_alarm_in_us(PIODCO_ENV_RAMP_US, PioDCOKeyUpAlarm, pdco, true);
+        if(pdco->_env_alarm > 0)
+        {
+            return;
+        }
+    }
+
+    pdco->_u8_key_up = YES;
+    PioDCORepublish(pdco);
+}
+
+/// @brief Shifts the phase of output by a fraction of on-air cycle, e.g. 500
+/// @brief is a 180 degrees reversal of BPSK. The worker delays one word by
+/// @brief the shift, so it takes effect at a word boundary and the freq
+/// @brief doesn't change.
+/// @param pdco Ptr to DCO context.
+/// @param i32_millicycles The shift, 1/1000 of cycle. Any sign, modulo 1000.
+/// @return 0 if OK. -1 the engine or the freq can't do it.
+/// @remark The shift is a delay, the negative one is made as the complement.
+/// @remark In harmonic mode the fundamental is shifted by 1/N of it.
+/// @attention The MASH, pattern and multi workers ignore the shifts.
+int PioDCOPhaseShift(PioDco *pdco, int32_t i32_millicycles)
+{
+    assert_(pdco);
+
+    if(eDCOENGINE_CPU != pdco->_engine && eDCOENGINE_TIMED != pdco->_engine
+       && eDCOENGINE_DMA != pdco->_engine)
+    {
+        return -1;
+    }
+
+    int32_t i32m = i32_millicycles % 1000;
+    if(i32m < 0)
+    {
+        i32m += 1000;
+    }
+    if(!i32m)
+    {
+        return 0;
+    }
+
+    const uint32_t u32irq = save_and_disable_interrupts();
+
+    /* The delay of fundamental is 2*PI*m/(1000*N), a quarter of it goes to
+       each half-period of dco word. */
+    const int64_t i64n2000 = 2000LL * pdco->_u8_harmonic_n;
+    const int32_t i32q = (int32_t)(((int64_t)pdco->_frq_cycles_per_pi * i32m + i64n2000 / 2)
+                                   / i64n2000);
+
+    /* dco16 delays a half-period by the whole shift, the count is to fit. */
+    const PioDcoFreqDesc *pdesc = &pdco->_freq[pdco->_u32_freq_seq & 1];
+    if(eDCOPROG_DCO16 == pdesc->_u8_program
+       && (uint64_t)pdesc->_i32_precise_cycles + 4ULL * i32q + (1ULL<<24) > UINT32_MAX)
+    {
+        restore_interrupts(u32irq);
+        return -1;
+    }
+
+    pdco->_i32_phase_total += i32q;
+    PioDCORepublish(pdco);
+    restore_interrupts(u32irq);
+
+    return 0;
+}
+
+/// @brief Makes a multi-phase group of DCOs, e.g. the I and Q LO of a mixer.
+/// @brief All of them run at the freq of the first one, with the offsets of
+/// @brief PioDCOSetPhaseOffset to it, and PioDCOWorkerPhased feeds them.
+/// @param apdco Array of ptrs to DCO contexts, initialized by PioDCOInit.
+/// @param n A count of DCOs, 2 to PIODCO_MAX_OUTPUTS.
+/// @return 0 if OK. -1 the DCOs aren't on the same PIO.
+/// @remark The freq, key and start of the first one apply to the group; the
+/// @remark others are never set up nor started by themselves.
+int PioDCOPhaseGroupInit(PioDco *apdco[], int n)
+{
+    assert_(apdco);
+    assert_(n > 1 && n <= PIODCO_MAX_OUTPUTS);
+
+    PioDco *pdco = apdco[0];
+    for(int i = 0; i < n; ++i)
+    {
+        if(apdco[i]->_pio != pdco->_pio)
+        {
+            return -1;
+        }
+    }
+
+    for(int i = 0; i < n; ++i)
+    {
+        apdco[i]->_pgroup = pdco;
+        apdco[i]->_i16_phase_offset = 0;
+        apdco[i]->_u32_phase_delay = 0;
+        pdco->_apgroup[i] = apdco[i];
+    }
+    pdco->_u8_group_n = n;
+
+    return 0;
+}
+
+/// @brief Sets the phase offset of DCO of phase group to the first one, e.g.
+/// @brief 250 is 90 degrees, the Q of a quadrature LO. It is kept through the
+/// @brief freq changes.
+/// @param pdco Ptr to DCO context.
+/// @param i32_millicycles The offset, 1/1000 of on-air cycle. Any sign, modulo 1000.
+/// @remark The offset is a delay of whole PIO CLK cycles, the nearest one to
+/// @remark the offset at the current freq; PioDCOGetPhaseOffset tells it.
+void PioDCOSetPhaseOffset(PioDco *pdco, int32_t i32_millicycles)
+{
+    assert_(pdco);
+    assert_(pdco->_pgroup);
+
+    int32_t i32m = i32_millicycles % 1000;
+    if(i32m < 0)
+    {
+        i32m += 1000;
+    }
+    pdco->_i16_phase_offset = i32m;
+    PioDCORepublish(pdco->_pgroup);
+}
+
+/// @brief Gets the phase offset of DCO of phase group to the first one, which
+/// @brief is applied by the worker at the current freq.
+/// @param pdco Ptr to DCO context.
+/// @return The offset, 1/1000 of on-air cycle.
+/// @remark It differs from the one set by at most 3/4 PIO CLK cycle.
+int32_t PioDCOGetPhaseOffset(const PioDco *pdco)
+{
+    assert_(pdco);
+    assert_(pdco->_pgroup);
+
+    /* The period of fundamental is 2 PI, the harmonic scales the phase. */
+    const PioDco *pfirst = pdco->_pgroup;
+    const int64_t i64period = 2LL * pfirst->_frq_cycles_per_pi;
+    if(!i64period)
+    {
+        return 0;
+    }
+    const int64_t i64m = (((int64_t)pdco->_u32_phase_delay * 1000LL * pfirst->_u8_harmonic_n) << 24)
+                         + (i64period >> 1);
+
+    return (int32_t)((i64m / i64period) % 1000);
+}
+
+/// @brief Puts a word to the FIFO of SM.
+/// @param pio The PIO of DCO.
+/// @param sm The SM of DCO.
+/// @param u32val The word.
+/// @param u32depth The max words queued, if limited.
+/// @param limited Whether the queue is limited to fewer words than FIFO.
+static __force_inline void PioDCOPut(PIO pio, uint sm, uint32_t u32val, uint32_t u32depth,
+                                     const int limited)
+{
+    if(limited)
+    {
+        while(pio_sm_get_tx_fifo_level(pio, sm) >= u32depth)
+        {
+            tight_loop_contents();
+        }
+        pio_sm_put(pio, sm, u32val);
+    }
+    else
+    {
+        pio_sm_put_blocking(pio, sm, u32val);
+    }
+}
+
+/// @brief The loop of worker V.2 for dco u-program: a word per 4 half-periods.
+/// @param pDCO Ptr to DCO context.
+/// @param u32word The index of the next word.
+/// @param limited Whether the FIFO depth is limited.
+/// @return The index of the next word, when the freq needs another u-program.
+/// @remark It is force inlined so that the limited loop is a separate one.
+/// @remark The unlimited one runs the assembly kernel of the core type, if
+/// @remark there is one, between the polls and FIFO samples.
+static __force_inline uint32_t PioDCOLoop2(PioDco *pDCO, uint32_t u32word, const int limited)
+{
+    register PIO pio = pDCO->_pio;
+    register uint sm = pDCO->_ism;
+    register uint32_t u32depth = pDCO->_u8_fifo_depth;
+    int32_t i32acc_error = 0;
+    register uint32_t i32wc;
+    int32_t i32reg = 0;
+    uint32_t u32seq = ~pDCO->_u32_freq_seq;
+#ifdef PIODCO_KERNEL_CYCLES_PER_WORD
+    PioDcoKernel kernel;
+    kernel._pu32_txf = &pio->txf[sm];
+    kernel._pu32_fstat = &pio->fstat;
+    kernel._u32_txfull = 1U << (PIO_FSTAT_TXFULL_LSB + sm);
+    kernel._pu32_seq = &pDCO->_u32_freq_seq;
+#endif
+    
+LOOP:
+    if(PioDCOPollFreq(pDCO, &u32seq, &i32reg, NULL, &i32acc_error, u32word))
+    {
+        return u32word;
+    }
+#ifdef PIODCO_KERNEL_CYCLES_PER_WORD
+    if(!limited)
+    {
+        /* The words up to the next FIFO sample, unless a freq is published. */
+        PioDCOSampleFifo(pDCO, u32word);
+        kernel._u32_seq = u32seq;
+        kernel._i32_reg = i32reg;
+        kernel._i32_acc = i32acc_error;
+        u32word += PioDCOKernel2(&kernel, PIODCO_FIFO_SAMPLE_WORDS - (u32word & (PIODCO_FIFO_SAMPLE_WORDS - 1)));
+        i32acc_error = kernel._i32_acc;
+
+        goto LOOP;
+    }
+#endif
+    i32wc = ((uint32_t)i32reg - i32acc_error) >> 24U;
+    PioDCOSampleFifo(pDCO, u32word);
+    PioDCOPut(pio, sm, i32wc, u32depth, limited);
+    i32acc_error += (i32wc << 24U) - i32reg;
+    ++u32word;
+    
+    goto LOOP;
+}
+
+#if defined(PIODCO_KERNEL_CYCLES_PER_WORD) && defined(PIODCO_KERNEL_PROFILE)
+#define PIODCO_KERNEL_PROFILE_WORDS 1024    /* The shorter run of the two. */
+#if defined(__riscv)
+#define PIODCO_KERNEL_CYCLE_MASK 0xFFFFFFFFU    /* mcycle, 32 bits used. */
+#else
+#define PIODCO_KERNEL_CYCLE_MASK 0x00FFFFFFU    /* SysTick is 24 bits. */
+#endif
+
+/// @brief Reads the CPU CLK cycle counter of the core, it counts up.
+/// @return The count, PIODCO_KERNEL_CYCLE_MASK bits of it are valid.
+static __force_inline uint32_t PioDCOKernelCycles(void)
+{
+#if defined(__riscv)
+    return riscv_read_csr(mcycle);
+#else
+    return ~systick_hw->cvr;
+#endif
+}
+
+/// @brief Times the kernel of dco u-program on the calling core, to check it
+/// @brief against PIODCO_KERNEL_CYCLES_PER_WORD. The kernel feeds a word in
+/// @brief RAM whose FSTAT never reads full, which is the case the budget is
+/// @brief counted for. Two runs of different length are timed, so that the
+/// @brief call and the return cancel out.
+/// @return CPU CLK cycles per word, scaled by 2^8.
+/// @remark A debug aid. It takes over SysTick on ARM for a while.
+uint32_t PioDCOKernelProfile(void)
+{
+    static uint32_t su32txf, su32fstat, su32seq;
+    PioDcoKernel kernel;
+    kernel._pu32_txf = &su32txf;
+    kernel._pu32_fstat = &su32fstat;
+    kernel._u32_txfull = 1U;
+    kernel._pu32_seq = &su32seq;
+    kernel._u32_seq = su32seq;
+    kernel._i32_reg = 25 << 24;
+    kernel._i32_acc = 0;
+
+    const uint32_t u32irq = save_and_disable_interrupts();
+#if defined(__riscv)
+    riscv_clear_csr(mcountinhibit, 1U);
+#else
+    const uint32_t u32csr = systick_hw->csr;
+    systick_hw->rvr = PIODCO_KERNEL_CYCLE_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5U;                 /* CPU CLK, enabled, no IRQ. */
+#endif
+
+    uint32_t u32cycles[2];
+    for(int i = 0; i < 2; ++i)
+    {
+        const uint32_t u32words = PIODCO_KERNEL_PROFILE_WORDS << i;
+        const uint32_t u32t0 = PioDCOKernelCycles();
+        const uint32_t u32fed = PioDCOKernel2(&kernel, u32words);
+        u32cycles[i] = (PioDCOKernelCycles() - u32t0) & PIODCO_KERNEL_CYCLE_MASK;
+        assert_(u32words == u32fed);
+    }
+
+#if !defined(__riscv)
+    systick_hw->csr = u32csr;
+#endif
+    restore_interrupts(u32irq);
+
+    return ((u32cycles[1] - u32cycles[0]) << 8) / PIODCO_KERNEL_PROFILE_WORDS;
+}
+#endif
+
+/// @brief The loop of worker V.2 for dco16 u-program: the PLL error is corrected
+/// @brief every half-period, two 16-bit counts per word. The low and the high
+/// @brief halves have their own cycles, which sets the duty.
+/// @param pDCO Ptr to DCO context.
+/// @param u32word The index of the next word.
+/// @param limited Whether the FIFO depth is limited.
+/// @return The index of the next word, when the freq needs another u-program.
+static __force_inline uint32_t PioDCOLoop16(PioDco *pDCO, uint32_t u32word, const int limited)
+{
+    register PIO pio = pDCO->_pio;
+    register uint sm = pDCO->_ism;
+    register uint32_t u32depth = pDCO->_u8_fifo_depth;
+    int32_t i32acc_error = 0;
+    register uint32_t i32wc0, i32wc1;
+    int32_t i32reg = 0, i32mark = 0;
+    uint32_t u32seq = ~pDCO->_u32_freq_seq;
+
+LOOP:
+    if(PioDCOPollFreq(pDCO, &u32seq, &i32reg, &i32mark, &i32acc_error, u32word))
+    {
+        return u32word;
+    }
+    i32wc0 = ((uint32_t)i32reg - i32acc_error) >> 24U;
+    i32acc_error += (i32wc0 << 24U) - i32reg;
+    i32wc1 = ((uint32_t)i32mark - i32acc_error) >> 24U;
+    i32acc_error += (i32wc1 << 24U) - i32mark;
+    PioDCOSampleFifo(pDCO, u32word);
+    PioDCOPut(pio, sm, i32wc0 | (i32wc1 << 16U), u32depth, limited);
+    ++u32word;
+
+    goto LOOP;
+}
+
+/// @brief Main worker task of DCO V.2. It is time critical, so it ought to be run on
+/// @brief the dedicated pi pico core.
+/// @param pDCO Ptr to DCO context.
+/// @return No return. It spins forever.
+/// @remark It switches SM between dco and dco16 u-programs as the freq requires.
+void RAM (PioDCOWorker2)(PioDco *pDCO)
+{
+    uint32_t u32word = 0;
+    const int limited = pDCO->_u8_fifo_depth < PIODCO_FIFO_DEPTH;
+
+    for(;;)
+    {
+        PioDcoFreqDesc desc;
+        PioDCOReadFreqDesc(pDCO, &desc);
+        PioDCOSetProgram(pDCO, desc._u8_program);
+
+        if(eDCOPROG_DCO16 == pDCO->_program)
+        {
+            u32word = limited ? PioDCOLoop16(pDCO, u32word, YES) : PioDCOLoop16(pDCO, u32word, NO);
+        }
+        else
+        {
+            u32word = limited ? PioDCOLoop2(pDCO, u32word, YES) : PioDCOLoop2(pDCO, u32word, NO);
+        }
+    }
+}
+
+/// @brief Fills one ping-pong buffer of DMA engine with cycle counts. The PLL is
+/// @brief exactly the one of PioDCOWorker2, so the sequence of words is identical.
+/// @param pDCO Ptr to DCO context.
+/// @param pbuf Ptr to buffer of PIODCO_DMA_BUF_WORDS words.
+static void RAM (PioDCODMARefill)(PioDco *pDCO, uint32_t *pbuf)
+{
+    register int32_t i32acc_error = pDCO->_i32acc_error;
+    register uint32_t i32wc;
+
+    /* The whole buffer is made of the freq published at the refill. */
+    PioDcoFreqDesc desc;
+    const uint32_t u32seq = PioDCOReadFreqDesc(pDCO, &desc);
+    if(u32seq != pDCO->_u32_applied_seq)
+    {
+        pDCO->_u32_applied_word = pDCO->_u32_fed_words;
+        pDCO->_u32_applied_us = timer_hw->timerawl;
+        pDCO->_u32_applied_seq = u32seq;
+    }
+    PioDCOSampleFifo(pDCO, 0);
+    pDCO->_u32_fed_words += PIODCO_DMA_BUF_WORDS;
+
+    /* The phase shifts go to the first word of buffer. */
+    i32acc_error -= desc._i32_phase_total - pDCO->_i32_phase_applied;
+    pDCO->_i32_phase_applied = desc._i32_phase_total;
+
+    const register uint32_t i32reg = desc._i32_precise_cycles;
+
+    for(int i = 0; i < PIODCO_DMA_BUF_WORDS; ++i)
+    {
+        i32wc = (i32reg - i32acc_error) >> 24U;
+        pbuf[i] = i32wc;
+        i32acc_error += (i32wc << 24U) - i32reg;
+    }
+
+    pDCO->_i32acc_error = i32acc_error;
+}
+
+/// @brief DMA completion ISR. Refills the buffer which has just been sent
+/// @brief while the other channel of the pair is streaming its one.
+/// @remark A suspended DCO leaves its slot empty, so each slot is checked.
+static void RAM (PioDCODMAIrqHandler)(void)
+{
+    for(int j = 0; j < PIODCO_MAX_OUTPUTS; ++j)
+    {
+        PioDco *pDCO = spDMAdco[j];
+        if(!pDCO)
+        {
+            continue;
+        }
+        for(int i = 0; i < 2; ++i)
+        {
+            const uint32_t u32mask = 1U << pDCO->_dma_chan[i];
+            if(dma_hw->ints1 & u32mask)
+            {
+                dma_hw->ints1 = u32mask;
+                PioDCODMARefill(pDCO, pDCO->_ui32_dmabuf[i]);
+                dma_channel_set_read_addr(pDCO->_dma_chan[i], pDCO->_ui32_dmabuf[i], false);
+            }
+        }
+    }
+}
+
+/// @brief Initializes DMA engine of DCO: two DMA channels chained to each other
+/// @brief feed the PIO SM from ping-pong buffers. The buffers are refilled in
+/// @brief DMA_IRQ_1 handler which is installed once and enabled on the calling
+/// @brief core, that of worker. Each of several DCOs might be fed by DMA this way.
+/// @param pdco Ptr to DCO context.
+/// @return 0 if OK.
+int PioDCODMAInit(PioDco *pdco)
+{
+    assert_(pdco);
+
+    int ix = 0;
+    while(ix < PIODCO_MAX_OUTPUTS && spDMAdco[ix])
+    {
+        ++ix;
+    }
+    assert_(ix < PIODCO_MAX_OUTPUTS);
+
+    pdco->_i32acc_error = 0;
+    pdco->_u32_fed_words = 0;
+    pdco->_u32_applied_seq = ~pdco->_u32_freq_seq;
+
+    pdco->_dma_chan[0] = dma_claim_unused_channel(true);
+    pdco->_dma_chan[1] = dma_claim_unused_channel(true);
+
+    for(int i = 0; i < 2; ++i)
+    {
+        PioDCODMARefill(pdco, pdco->_ui32_dmabuf[i]);
+
+        dma_channel_config c = dma_channel_get_default_config(pdco->_dma_chan[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pio_get_dreq(pdco->_pio, pdco->_ism, true));
+        channel_config_set_chain_to(&c, pdco->_dma_chan[i ^ 1]);
+
+        dma_channel_configure(pdco->_dma_chan[i], &c, &pdco->_pio->txf[pdco->_ism],
+                              pdco->_ui32_dmabuf[i], PIODCO_DMA_BUF_WORDS, false);
+        dma_channel_set_irq1_enabled(pdco->_dma_chan[i], true);
+    }
+
+    spDMAdco[ix] = pdco;
+    if(!si_dma_irq_installed)
+    {
+        irq_set_exclusive_handler(DMA_IRQ_1, PioDCODMAIrqHandler);
+        si_dma_irq_installed = YES;
+    }
+    /* NVIC is per core and a reset of core clears it, so it is enabled on
+       the core of worker by each init. */
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(pdco->_dma_chan[0]);
+
+    return 0;
+}
+
+/// @brief Main worker task of DCO DMA engine. The PIO SM is fed by DMA, so
+/// @brief the core only wakes up to refill a buffer and might do other work.
+/// @param pDCO Ptr to DCO context.
+/// @return No return. It sleeps between DMA refills forever.
+void RAM (PioDCOWorkerDMA)(PioDco *pDCO)
+{
+    assert_(pDCO);
+    assert_(0 == PioDCODMAInit(pDCO));
+
+    for(;;)
+    {
+        __wfi();
+    }
+}
+
+#if PICO_RP2350
+/// @brief Hands the GPIO of DCO over to HSTX, which shifts out the bitstream
+/// @brief LSB first, two bits per its CLK: one on the rising edge and one on
+/// @brief the falling edge. The SM of DCO is left stopped.
+/// @param pdco Ptr to DCO context.
+static void PioDCOHstxInit(PioDco *pdco)
+{
+    pio_sm_set_enabled(pdco->_pio, pdco->_ism, false);
+
+    hstx_ctrl_hw->csr = 0;
+    hstx_ctrl_hw->bit[pdco->_gpio - PIODCO_HSTX_FIRST_GPIO] =
+        (0U << HSTX_CTRL_BIT0_SEL_P_LSB) | (1U << HSTX_CTRL_BIT0_SEL_N_LSB);
+    hstx_ctrl_hw->csr = (2U << HSTX_CTRL_CSR_SHIFT_LSB) | (16U << HSTX_CTRL_CSR_N_SHIFTS_LSB)
+        | (pdco->_is_enabled ? HSTX_CTRL_CSR_EN_BITS : 0);
+
+    gpio_set_function(pdco->_gpio, GPIO_FUNC_HSTX);
+}
+#endif
+
+/// @brief Initializes pattern engine of DCO: the data DMA channel sends a tone
+/// @brief pattern to PIO SM and chains to the select channel. It reads
+/// @brief _pu32_pattern_ctrl to the control channel, which then reloads both
+/// @brief the count and the read address of data channel from the control
+/// @brief block of the tone, and triggers it. Hence the pattern loops with no
+/// @brief CPU involved at all.
+/// @param pdco Ptr to DCO context.
+/// @return 0 if OK, -1 if another DCO runs the pattern engine.
+/// @remark A DMA ring can wrap power-of-two buffers only, it is too coarse
+/// @remark for WSPR tone spacing, so the control channel is used instead.
+/// @remark The count and the address come from one block, so a tone select,
+/// @remark a single store of the pointer, never mixes them between tones.
+/// @remark The 32 KB of patterns are shared, there is no RAM for a set per
+/// @remark DCO. They are released by PioDCOSuspend.
+int PioDCOPatternInit(PioDco *pdco)
+{
+    assert_(pdco);
+
+    if(spPatternDco && spPatternDco != pdco)
+    {
+        return -1;
+    }
+    spPatternDco = pdco;
+
+    for(int i = 0; i < PIODCO_DMA_CHANS; ++i)
+    {
+        pdco->_dma_chan[i] = dma_claim_unused_channel(true);
+    }
+
+    dma_channel_config c = dma_channel_get_default_config(pdco->_dma_chan[0]);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_chain_to(&c, pdco->_dma_chan[2]);
+#if PICO_RP2350
+    if(pdco->_u32_hstx_bit_hz)
+    {
+        channel_config_set_dreq(&c, DREQ_HSTX);
+        dma_channel_configure(pdco->_dma_chan[0], &c, &hstx_fifo_hw->fifo,
+                              NULL, PIODCO_PATTERN_MAX_WORDS, false);
+    }
+    else
+#endif
+    {
+        channel_config_set_dreq(&c, pio_get_dreq(pdco->_pio, pdco->_ism, true));
+        dma_channel_configure(pdco->_dma_chan[0], &c, &pdco->_pio->txf[pdco->_ism],
+                              NULL, PIODCO_PATTERN_MAX_WORDS, false);
+    }
+
+    /* {count, address} goes to the last two registers of alias 3. The write
+       address wraps on 8 bytes, so the next reload writes them again. */
+    c = dma_channel_get_default_config(pdco->_dma_chan[1]);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 3);
+    dma_channel_configure(pdco->_dma_chan[1], &c, &dma_hw->ch[pdco->_dma_chan[0]].al3_transfer_count,
+                          NULL, 2, false);
+
+    c = dma_channel_get_default_config(pdco->_dma_chan[2]);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(pdco->_dma_chan[2], &c, &dma_hw->ch[pdco->_dma_chan[1]].al3_read_addr_trig,
+                          &pdco->_pu32_pattern_ctrl, 1, false);
+
+    return 0;
+}
+
+/// @brief Sets the period of a tone pattern and its control block, the count
+/// @brief and the address the data channel is reloaded with.
+/// @param pdco Ptr to DCO context.
+/// @param itone Index of the tone.
+/// @param u32len The period, words.
+static void PioDCOPatternSetLength(PioDco *pdco, int itone, uint32_t u32len)
+{
+    pdco->_u16_pattern_len[itone] = u32len;
+    pdco->_u32_pattern_ctrl[itone][0] = u32len;
+    pdco->_u32_pattern_ctrl[itone][1] = (uint32_t)(uintptr_t)sui32_pattern[itone];
+}
+
+/// @brief Finds the best rational approximation p/q of num/den with q <= q_max
+/// @brief by continued fraction expansion, trying the last semiconvergent.
+/// @param u64num The numerator.
+/// @param u64den The denominator, non-zero.
+/// @param u32qmax The max denominator of approximation.
+/// @param pu32p Ptr to the numerator found.
+/// @param pu32q Ptr to the denominator found.
+static void PioDCOBestRational(uint64_t u64num, uint64_t u64den, uint32_t u32qmax,
+                               uint32_t *pu32p, uint32_t *pu32q)
+{
+    uint64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    uint64_t num = u64num, den = u64den;
+    while(den)
+    {
+        const uint64_t a = num / den;
+        if(a * q1 + q0 > u32qmax)
+        {
+            /* Try the best semiconvergent, which still fits. */
+            const uint64_t t = (u32qmax - q0) / q1;
+            const uint64_t ps = p0 + t * p1, qs = q0 + t * q1;
+            const int64_t i64err_s = (int64_t)(ps * u64den) - (int64_t)(u64num * qs);
+            const int64_t i64err_1 = (int64_t)(p1 * u64den) - (int64_t)(u64num * q1);
+            if(t && (i64err_s < 0 ? -i64err_s : i64err_s) * q1 < (i64err_1 < 0 ? -i64err_1 : i64err_1) * qs)
+            {
+                p1 = ps;
+                q1 = qs;
+            }
+            break;
+        }
+
+        const uint64_t p2 = a * p1 + p0, q2 = a * q1 + q0;
+        p0 = p1; q0 = q1;
+        p1 = p2; q1 = q2;
+
+        const uint64_t rem = num - a * den;
+        num = den;
+        den = rem;
+    }
+
+    *pu32p = (uint32_t)p1;
+    *pu32q = (uint32_t)q1;
+}
+
+/// @brief Fits the ratio of the fundamental to bit rate of dcobits u-program
+/// @brief or HSTX by the best rational approximation p/(32*q) with
+/// @brief q <= PIODCO_PATTERN_MAX_WORDS.
+/// @param pdco Ptr to DCO context.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @param pu32p Ptr to the cycles of RF per period.
+/// @param pu32q Ptr to the period, words.
+/// @return The freq. error of the waveform [mHz].
+static int32_t PioDCOBitstreamFit(const PioDco *pdco, uint32_t ui32_frq_hz, int32_t i32_frq_millihz,
+                                  uint32_t *pu32p, uint32_t *pu32q)
+{
+    /* Freq / bit rate * 32 = num / den, the freq in 1/2 mHz as that of
+       PioDCOCalcCyclesPerPi64. The PIO CLK is divided on LF only, HSTX
+       shifts out 2 bits per its CLK. */
+    const uint32_t u32bit_div = pdco->_u32_hstx_bit_hz ? 1U : pdco->_u16_clkdiv;
+    const uint32_t u32bit_clk = pdco->_u32_hstx_bit_hz ? pdco->_u32_hstx_bit_hz : pdco->_clkfreq_hz;
+    const uint64_t u64num = 32ULL * u32bit_div * (2000ULL * ui32_frq_hz + i32_frq_millihz);
+    const uint64_t u64den = 2000ULL * pdco->_u8_harmonic_n * u32bit_clk;
+    uint32_t p, q;
+    PioDCOBestRational(u64num, u64den, PIODCO_PATTERN_MAX_WORDS, &p, &q);
+    *pu32p = p;
+    *pu32q = q;
+
+    /* The error of p/q is that of freq * 32 * div scaled by den, 1/2 mHz. */
+    const int64_t i64err = (int64_t)((uint64_t)p * u64den) - (int64_t)(u64num * q);
+    return (int32_t)(i64err / (64LL * q * u32bit_div));
+}
+
+/// @brief Renders the repeating waveform of a tone for dcobits u-program or
+/// @brief HSTX. There are exactly p cycles of RF per q words of the fit of
+/// @brief PioDCOBitstreamFit, so the waveform loops seamlessly.
+/// @param pdco Ptr to DCO context.
+/// @param itone Index of the tone.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @remark The bit is high while the phase of fundamental is below the duty.
+/// @remark The edges land on PIO CLK, the same as those of dco u-program,
+/// @remark or on either edge of HSTX CLK.
+static void PioDCOBitstreamBuild(PioDco *pdco, int itone, uint32_t ui32_frq_hz, int32_t i32_frq_millihz)
+{
+    uint32_t p, q;
+    pdco->_i32_pattern_err_millihz[itone] = PioDCOBitstreamFit(pdco, ui32_frq_hz, i32_frq_millihz, &p, &q);
+
+    /* The accumulator is the phase of bit, 32 * q units per cycle of RF. */
+    const uint32_t u32period = 32U * q;
+    const uint32_t u32mark = (uint32_t)(((uint64_t)u32period * pdco->_u16_duty_permille + 500U) / 1000U);
+    uint32_t *pu32 = sui32_pattern[itone];
+    uint32_t acc = 0;
+    for(uint32_t i = 0; i < q; ++i)
+    {
+        uint32_t u32bits = 0;
+        for(int ib = 0; ib < 32; ++ib)
+        {
+            u32bits |= (uint32_t)(acc < u32mark) << ib;
+            acc += p;
+            if(acc >= u32period)
+            {
+                acc -= u32period;
+            }
+        }
+        pu32[i] = u32bits;
+    }
+
+    PioDCOPatternSetLength(pdco, itone, q);
+}
+
+/// @brief Fits the cycle counts of a freq. The 2^24 fraction of cycles is
+/// @brief replaced by the best rational approximation p/q with
+/// @brief q <= PIODCO_PATTERN_MAX_WORDS.
+/// @param pdco Ptr to DCO context.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @param pu32int Ptr to the integer part of cycles.
+/// @param pu32p Ptr to the count of words of one cycle more per period.
+/// @param pu32q Ptr to the period, words.
+/// @return The freq. error of the pattern [mHz].
+static int32_t PioDCOCountsFit(const PioDco *pdco, uint32_t ui32_frq_hz, int32_t i32_frq_millihz,
+                               uint32_t *pu32int, uint32_t *pu32p, uint32_t *pu32q)
+{
+    const int32_t i32cycles_per_pi = PioDCOCalcCyclesPerPi(pdco, ui32_frq_hz, i32_frq_millihz);
+    const uint32_t u32reg = i32cycles_per_pi - (PIOASM_DELAY_CYCLES<<24);
+    const uint32_t u32frac = u32reg & 0xFFFFFFU;
+    uint32_t p1, q1;
+    PioDCOBestRational(u32frac, 1U<<24, PIODCO_PATTERN_MAX_WORDS, &p1, &q1);
+    *pu32int = u32reg >> 24U;
+    *pu32p = p1;
+    *pu32q = q1;
+
+    /* Relative freq. error is the error of cycles divided by cycles per PI. */
+    const int64_t i64err = (int64_t)p1 * (1<<24) - (int64_t)u32frac * q1;
+    const int64_t i64frq_millihz = 1000LL * (int64_t)ui32_frq_hz + (int64_t)i32_frq_millihz;
+    return (int32_t)(-i64frq_millihz * i64err / ((int64_t)q1 * i32cycles_per_pi));
+}
+
+/// @brief Calculates the freq. error the pattern of a freq would have, with
+/// @brief no pattern built, so that the caller can choose the freq of
+/// @brief patterns fitting best.
+/// @param pdco Ptr to DCO context.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @return The freq. error [mHz], the same as PioDCOPatternBuild stores.
+int32_t PioDCOPatternError(const PioDco *pdco, uint32_t ui32_frq_hz, int32_t i32_frq_millihz)
+{
+    assert_(pdco);
+
+    uint32_t u32int, p, q;
+    if(eDCOENGINE_BITSTREAM == pdco->_engine)
+    {
+        return PioDCOBitstreamFit(pdco, ui32_frq_hz, i32_frq_millihz, &p, &q);
+    }
+    return PioDCOCountsFit(pdco, ui32_frq_hz, i32_frq_millihz, &u32int, &p, &q);
+}
+
+/// @brief Calculates the repeating pattern of cycle counts of a tone. The
+/// @brief fit of PioDCOCountsFit repeats exactly each q words. The rest of
+/// @brief the buffer is filled by the same pattern.
+/// @param pdco Ptr to DCO context.
+/// @param itone Index of the tone.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @return 0 if OK. The period and freq. error are stored to the context.
+/// @remark The bitstream engine gets the rendered waveform instead.
+/// @attention It takes a while, so it ought not to be called from ISR.
+int PioDCOPatternBuild(PioDco *pdco, int itone, uint32_t ui32_frq_hz, int32_t i32_frq_millihz)
 {
     assert_(pdco);
-  
-    memset(pdco, 0, sizeof(PioDco));
+    assert_(itone >= 0 && itone < PIODCO_PATTERN_TONES);
 
-    //pdco->_clkfreq_hz = cpuclkhz;
-    pdco->_pio = pio0;
-    pdco->_gpio = gpio;
-    pdco->_offset = pio_add_program(pdco->_pio, &dco_program);
-    pdco->_ism = pio_claim_unused_sm(pdco->_pio, true);
+    if(eDCOENGINE_BITSTREAM == pdco->_engine)
+    {
+        PioDCOBitstreamBuild(pdco, itone, ui32_frq_hz, i32_frq_millihz);
+        return 0;
+    }
 
-    gpio_init(pdco->_gpio);
-    pio_gpio_init(pdco->_pio, pdco->_gpio);
+    uint32_t u32int, p1, q1;
+    pdco->_i32_pattern_err_millihz[itone] = 
+        PioDCOCountsFit(pdco, ui32_frq_hz, i32_frq_millihz, &u32int, &p1, &q1);
 
-    dco_program_init(pdco->_pio, pdco->_ism, pdco->_offset, pdco->_gpio);
-    pdco->_pio_sm = dco_program_get_default_config(pdco->_offset);
+    /* The accumulator equals i*p mod q, so it returns to 0 each q words. */
+    uint32_t *pu32 = sui32_pattern[itone];
+    uint32_t acc = 0;
+    for(int i = 0; i < PIODCO_PATTERN_MAX_WORDS; ++i)
+    {
+        acc += p1;
+        if(acc >= q1)
+        {
+            acc -= q1;
+            pu32[i] = u32int + 1;
+        }
+        else
+        {
+            pu32[i] = u32int;
+        }
+    }
 
-    sm_config_set_out_shift(&pdco->_pio_sm, true, true, 32);           // Autopull.
-    sm_config_set_fifo_join(&pdco->_pio_sm, PIO_FIFO_JOIN_TX);
-    sm_config_set_set_pins(&pdco->_pio_sm, pdco->_gpio, 1);
-    
-    pio_sm_init(pdco->_pio, pdco->_ism, pdco->_offset, &pdco->_pio_sm);
+    PioDCOPatternSetLength(pdco, itone, q1);
 
     return 0;
 }
 
-/// @brief Sets DCO working frequency in Hz: Fout = ui32_frq_hz + ui32_frq_millihz * 1e-3.
+/// @brief Switches the pattern engine to the tone. It takes effect when the
+/// @brief current period of the pattern ends, so the phase is continuous.
 /// @param pdco Ptr to DCO context.
-/// @param i32_frq_hz The `coarse` part of frequency [Hz]. Might be negative.
-/// @param ui32_frq_millihz The `fine` part of frequency [Hz].
-/// @return 0 if OK. -1 invalid freq.
-/// @attention The func can be called while DCO running.
-int PioDCOSetFreq(PioDco *pdco, uint32_t ui32_frq_hz, int32_t ui32_frq_millihz)
+/// @param itone Index of the tone. Others, such as key up, are ignored.
+/// @attention The func can be called from ISR.
+/// @remark The select is a single store of the control block pointer, the
+/// @remark DMA reads either the old block or the new one as a whole.
+void RAM (PioDCOPatternSelect)(PioDco *pdco, int itone)
 {
-    assert_(pdco);
+    if(pdco->_dma_chan[2] < 0 || itone < 0 || itone >= PIODCO_PATTERN_TONES)
+    {
+        return;
+    }
 
-    /* RPix: Calculate an accurate value of phase increment of the freq 
-       per 1 tick of CPU clock, here 2^24 is scaling coefficient. */
-    const int64_t i64denominator = 2000LL * (int64_t)ui32_frq_hz + (int64_t)ui32_frq_millihz;
-    pdco->_frq_cycles_per_pi = (int32_t)(((int64_t)(PLL_SYS_MHZ * MHz) * (int64_t)(1<<24) * 1000LL
-                                         +(i64denominator>>1)) / i64denominator);
+    const int is_running = NULL != pdco->_pu32_pattern_ctrl;
+    pdco->_pu32_pattern_ctrl = pdco->_u32_pattern_ctrl[itone];
+    if(!is_running)
+    {
+        dma_channel_start(pdco->_dma_chan[2]);
+    }
+}
+
+/// @brief Main worker task of DCO pattern and bitstream engines. The PIO SM
+/// @brief is fed by DMA with no CPU involved, so the core is free after the
+/// @brief initialization.
+/// @param pDCO Ptr to DCO context.
+/// @return No return. It sleeps forever.
+void RAM (PioDCOWorkerPattern)(PioDco *pDCO)
+{
+    assert_(pDCO);
+    assert_(0 == PioDCOPatternInit(pDCO));
 
-    si32precise_cycles = pdco->_frq_cycles_per_pi - (PIOASM_DELAY_CYCLES<<24);
+    if(eDCOENGINE_BITSTREAM == pDCO->_engine)
+    {
+#if PICO_RP2350
+        if(pDCO->_u32_hstx_bit_hz)
+        {
+            PioDCOHstxInit(pDCO);
+        }
+        else
+#endif
+        {
+            PioDCOSetProgram(pDCO, eDCOPROG_BITS);
+        }
+    }
 
-    pdco->_ui32_frq_hz = ui32_frq_hz;
-    pdco->_ui32_frq_millihz = ui32_frq_millihz;
+    /* Start with the carrier of working freq. */
+    PioDcoFreqDesc desc;
+    PioDCOReadFreqDesc(pDCO, &desc);
+    PioDCOPatternBuild(pDCO, 0, desc._ui32_frq_hz, desc._i32_frq_millihz);
+    PioDCOPatternSelect(pDCO, 0);
 
-    return 0;
+    for(;;)
+    {
+        __wfe();
+    }
 }
 
-/// @brief Obtains the frequency shift [milliHz] which is calculated for a given frequency.
-/// @param pdco Ptr to Context.
-/// @param u64_desired_frq_millihz The frequency for which we want to calculate correction.
-/// @return The value of correction we need to subtract from desired freq. to compensate
-/// @return Pico's reference clock shift. 2854974.
-int32_t PioDCOGetFreqShiftMilliHertz(const PioDco *pdco, uint64_t u64_desired_frq_millihz)
+/// @brief The loop of MASH 1-1-1 worker. The integer part of cycles goes directly
+/// @brief to output, the 2^24 fraction goes to the cascade of 1st order
+/// @brief accumulators, their carries are combined so that the quantization
+/// @brief noise is shaped by (1-z^-1)^order, pushing spurs off the carrier.
+/// @param pDCO Ptr to DCO context.
+/// @param order The order of noise shaping, 1..3.
+/// @param dither Whether 1 LSB of PRN32 dither is added to the fraction.
+/// @remark It is force inlined so that every combination is a separate loop.
+/// @remark It returns when a freq needs another order.
+static __force_inline void PioDCOMASHLoop(PioDco *pDCO, const int order, const int dither)
 {
-    assert_(pdco);
-    if(!pdco->_pGPStime)
+    register PIO pio = pDCO->_pio;
+    register uint sm = pDCO->_ism;
+    register uint32_t u32acc1 = 0, u32acc2 = 0, u32acc3 = 0;
+    register int32_t i32c2z = 0, i32c3z = 0, i32c3zz = 0;
+    uint32_t u32lfsr = 0x9E3779B9;
+    int32_t i32reg = 0;
+    uint32_t u32seq = ~pDCO->_u32_freq_seq;
+    register uint32_t u32word = 0;
+
+    for(;; ++u32word)
     {
-        return 0U;
+        if(PioDCOPollFreq(pDCO, &u32seq, &i32reg, NULL, NULL, u32word))
+        {
+            return;
+        }
+        const register uint32_t u32reg = i32reg;
+        register int32_t i32wc = u32reg >> 24U;
+
+        u32acc1 += u32reg & 0xFFFFFFU;
+        if(dither)
+        {
+            PRN32(&u32lfsr);
+            u32acc1 += u32lfsr & 1U;
+        }
+        i32wc += u32acc1 >> 24U;
+        u32acc1 &= 0xFFFFFFU;
+
+        if(order > 1)
+        {
+            u32acc2 += u32acc1;
+            const register int32_t i32c2 = u32acc2 >> 24U;
+            u32acc2 &= 0xFFFFFFU;
+
+            if(order > 2)
+            {
+                u32acc3 += u32acc2;
+                const register int32_t i32c3 = u32acc3 >> 24U;
+                u32acc3 &= 0xFFFFFFU;
+
+                i32wc += i32c3 - 2 * i32c3z + i32c3zz;
+                i32c3zz = i32c3z;
+                i32c3z = i32c3;
+            }
+
+            i32wc += i32c2 - i32c2z;
+            i32c2z = i32c2;
+        }
+
+        /* The order fits the freq, this only keeps a too low harmonic set
+           explicitly from a word of ~2^32 cycles. */
+        if(__builtin_expect(i32wc < 1, 0))
+        {
+            i32wc = 1;
+        }
+
+        PioDCOSampleFifo(pDCO, u32word);
+        pio_sm_put_blocking(pio, sm, i32wc);
     }
+}
 
-    static int64_t i64_last_correction = 0;
-    const int64_t dt = pdco->_pGPStime->_time_data._i32_freq_shift_ppb; /* Parts per billion. */
-    if(dt)
+/// @brief Runs the MASH loop of an order until a freq needs another one.
+/// @param pDCO Ptr to DCO context.
+/// @param order The order of noise shaping, 1..3.
+static void RAM (PioDCOWorkerMASHOrder)(PioDco *pDCO, int order)
+{
+    switch(order)
     {
-        i64_last_correction = dt;
+        case 3:
+            pDCO->_u8_dither ? PioDCOMASHLoop(pDCO, 3, YES) : PioDCOMASHLoop(pDCO, 3, NO);
+            break;
+
+        case 2:
+            pDCO->_u8_dither ? PioDCOMASHLoop(pDCO, 2, YES) : PioDCOMASHLoop(pDCO, 2, NO);
+            break;
+
+        default:
+            pDCO->_u8_dither ? PioDCOMASHLoop(pDCO, 1, YES) : PioDCOMASHLoop(pDCO, 1, NO);
+            break;
     }
+}
 
-    int32_t i32ret_millis;
-    if(i64_last_correction)
-    {
-        int64_t i64corr_coeff = (u64_desired_frq_millihz + 500000LL) / 1000000LL;
-        i32ret_millis = (i64_last_correction * i64corr_coeff + 50000LL) / 1000000LL;
+/// @brief Main worker task of DCO with MASH noise shaping. It is time critical,
+/// @brief so it ought to be run on the dedicated pi pico core.
+/// @param pDCO Ptr to DCO context.
+/// @return No return. It spins forever.
+/// @remark The order is that of the freq published, lower than the one set
+/// @remark where the word would go below zero.
+void RAM (PioDCOWorkerMASH)(PioDco *pDCO)
+{
+    assert_(pDCO);
 
-        return i32ret_millis;
+    for(;;)
+    {
+        PioDcoFreqDesc desc;
+        PioDCOReadFreqDesc(pDCO, &desc);
+        pDCO->_u8_mash_run = desc._u8_mash_order;
+        PioDCOWorkerMASHOrder(pDCO, desc._u8_mash_order);
     }
+}
 
-    return 0U;
+/// @brief Queues a freq command to be applied by PioDCOWorkerTimed when the
+/// @brief timer passes the time given. Only one core might push.
+/// @param pdco Ptr to DCO context.
+/// @param u64_time_us The timer time to apply the freq at, us.
+/// @param ui32_frq_hz The `coarse` part of frequency [Hz].
+/// @param i32_frq_millihz The `fine` part of frequency [mHz].
+/// @return 0 if OK. -1 the queue is full.
+/// @attention The PIO CLK divider is that of working freq, so the freq has to
+/// @attention be on the same band as the one set by PioDCOSetFreq.
+int PioDCOTimedPush(PioDco *pdco, uint64_t u64_time_us, uint32_t ui32_frq_hz, int32_t i32_frq_millihz)
+{
+    assert_(pdco);
+
+    PioDcoTimedCmd cmd;
+    cmd._u64_time_us = u64_time_us;
+    cmd._i32_precise_cycles = PioDCOCalcCyclesPerPi(pdco, ui32_frq_hz, i32_frq_millihz)
+                            - (PIOASM_DELAY_CYCLES<<24);
+
+    return PioDcoTimedRingPush(&pdco->_timed, &cmd) ? 0 : -1;
 }
 
-/// @brief Starts the DCO.
+/// @brief Drops the commands pending in the timed queue. It waits for the
+/// @brief worker, so PioDCOWorkerTimed has to be running if any are pending.
 /// @param pdco Ptr to DCO context.
-void PioDCOStart(PioDco *pdco)
+void PioDCOTimedFlush(PioDco *pdco)
 {
     assert_(pdco);
-    pio_sm_set_enabled(pdco->_pio, pdco->_ism, true);
 
-    pdco->_is_enabled = YES;
+    if(PioDcoTimedRingCount(&pdco->_timed))
+    {
+        pdco->_u8_timed_flush = YES;
+        while(pdco->_u8_timed_flush)
+        {
+            tight_loop_contents();
+        }
+    }
 }
 
-/// @brief Stops the DCO.
+/// @brief Clears the histogram of edge lateness of the timed queue.
 /// @param pdco Ptr to DCO context.
-void PioDCOStop(PioDco *pdco)
+void PioDCOTimedClearHistogram(PioDco *pdco)
 {
     assert_(pdco);
-    pio_sm_set_enabled(pdco->_pio, pdco->_ism, false);
 
-    pdco->_is_enabled = NO;
+    memset(pdco->_u32_edge_hist, 0, sizeof(pdco->_u32_edge_hist));
+    pdco->_u32_edge_late_max_us = 0;
 }
 
-/// @brief Main worker task of DCO V.2. It is time critical, so it ought to be run on
-/// @brief the dedicated pi pico core.
+/// @brief Applies the head of timed queue if its time has come, and accounts
+/// @brief the lateness of the edge in the histogram.
+/// @param pDCO Ptr to DCO context.
+/// @param pi32cycles Ptr to the cycles per word the worker uses.
+/// @remark Only the low word of timer is compared, which is wrap-safe for
+/// @remark commands queued up to ~35 minutes ahead.
+static __force_inline void PioDCOPollTimed(PioDco *pDCO, int32_t *pi32cycles)
+{
+    const PioDcoTimedCmd *pcmd = PioDcoTimedRingPeek(&pDCO->_timed);
+    if(__builtin_expect(!pcmd, 1))
+    {
+        return;
+    }
+
+    if(pDCO->_u8_timed_flush)
+    {
+        PioDcoTimedRingDropAll(&pDCO->_timed);
+        pDCO->_u8_timed_flush = NO;
+        return;
+    }
+
+    const uint32_t u32late = timer_hw->timerawl - (uint32_t)pcmd->_u64_time_us;
+    if((int32_t)u32late < 0)
+    {
+        return;
+    }
+
+    *pi32cycles = pcmd->_i32_precise_cycles;
+    PioDcoTimedRingDrop(&pDCO->_timed);
+    if(pDCO->_u8_fifo_flush)
+    {
+        pio_sm_clear_fifos(pDCO->_pio, pDCO->_ism);
+    }
+
+    int ibin = u32late ? 32 - __builtin_clz(u32late) : 0;
+    if(ibin >= PIODCO_EDGE_HIST_BINS)
+    {
+        ibin = PIODCO_EDGE_HIST_BINS - 1;
+    }
+    ++pDCO->_u32_edge_hist[ibin];
+    if(u32late > pDCO->_u32_edge_late_max_us)
+    {
+        pDCO->_u32_edge_late_max_us = u32late;
+    }
+}
+
+/// @brief Main worker task of DCO with timed queue. It is PioDCOWorker2 which
+/// @brief also applies queued freq commands at their time, so symbol edges
+/// @brief don't depend on core0 interrupt latency. It is time critical, so it
+/// @brief ought to be run on the dedicated pi pico core.
 /// @param pDCO Ptr to DCO context.
 /// @return No return. It spins forever.
-void RAM (PioDCOWorker2)(PioDco *pDCO)
+/// @remark The edge resolution is the timer tick or a word period, whichever
+/// @remark is longer.
+void RAM (PioDCOWorkerTimed)(PioDco *pDCO)
 {
+    assert_(pDCO);
+
     register PIO pio = pDCO->_pio;
     register uint sm = pDCO->_ism;
-    register int32_t i32acc_error = 0;
-    register uint32_t i32wc, i32reg;
-    
-LOOP:
-    i32reg = si32precise_cycles;
-    i32wc = (i32reg - i32acc_error) >> 24U;
-    pio_sm_put_blocking(pio, sm, i32wc);
-    i32acc_error += (i32wc << 24U) - i32reg;
-    
-    goto LOOP;
+    register uint32_t u32depth = pDCO->_u8_fifo_depth;
+    int32_t i32acc_error = 0;
+    register uint32_t i32wc;
+    int32_t i32reg = 0;
+    uint32_t u32seq = ~pDCO->_u32_freq_seq;
+    register uint32_t u32word = 0;
+
+    for(;; ++u32word)
+    {
+        PioDCOPollFreq(pDCO, &u32seq, &i32reg, NULL, &i32acc_error, u32word);
+        PioDCOPollTimed(pDCO, &i32reg);
+
+        i32wc = ((uint32_t)i32reg - i32acc_error) >> 24U;
+        PioDCOSampleFifo(pDCO, u32word);
+        PioDCOPut(pio, sm, i32wc, u32depth, u32depth < PIODCO_FIFO_DEPTH);
+        i32acc_error += (i32wc << 24U) - i32reg;
+    }
+}
+
+/// @brief Calculates the phase delays of the DCOs of phase group at the freq.
+/// @param apDCO Array of ptrs to DCO contexts of group.
+/// @param n A count of DCOs.
+/// @param i32reg Cycles per PI less delay of the freq, scaled by 2^24.
+/// @param pu32delay Ptr to the delays in use, PIO CLK cycles.
+/// @return Non-zero if a delay has moved by 3/4 cycle or more, so the group is
+/// @return to be synced. The smaller moves are ignored, so that the tones close
+/// @return to a rounding boundary don't make it sync on every change.
+static int PioDCOPhaseGroupDelays(PioDco *apDCO[], int n, int32_t i32reg, uint32_t *pu32delay)
+{
+    const int64_t i64period = 2LL * ((int64_t)i32reg + (PIOASM_DELAY_CYCLES << 24));
+    const int64_t i64den = 1000LL * apDCO[0]->_u8_harmonic_n;
+
+    int changed = NO;
+    for(int i = 0; i < n; ++i)
+    {
+        /* The delay of the offset, 1/4 PIO CLK cycle. */
+        const int64_t i64q = ((i64period * apDCO[i]->_i16_phase_offset * 4LL / i64den) + (1 << 23)) >> 24;
+        const int64_t i64move = i64q - 4LL * pu32delay[i];
+        if(i64move >= 3 || i64move <= -3)
+        {
+            pu32delay[i] = (uint32_t)((i64q + 2) >> 2);
+            changed = YES;
+        }
+        apDCO[i]->_u32_phase_delay = pu32delay[i];
+    }
+
+    return changed;
+}
+
+/// @brief Restarts the SMs of phase group in lockstep. Each one is loaded with
+/// @brief the first word, its first half-period stretched by its phase delay,
+/// @brief and the same words after it; then all are enabled at the same PIO CLK.
+/// @param apDCO Array of ptrs to DCO contexts of group.
+/// @param n A count of DCOs.
+/// @param u32mask The mask of their SMs.
+/// @param pu32delay Ptr to the phase delays, PIO CLK cycles.
+/// @param i32reg Cycles per PI less delay, scaled by 2^24.
+/// @param pi32acc Ptr to the PLL accumulated error.
+/// @return The count of words sent to each SM.
+/// @remark The outputs stop for a few us and start low.
+static uint32_t RAM (PioDCOPhaseGroupSync)(PioDco *apDCO[], int n, uint32_t u32mask,
+                                           const uint32_t *pu32delay, int32_t i32reg, int32_t *pi32acc)
+{
+    PioDco *pDCO = apDCO[0];
+    const PIO pio = pDCO->_pio;
+
+    pio_set_sm_mask_enabled(pio, u32mask, false);
+
+    /* The SM starts at LOOP0 as if it has pulled the word to y and copied it
+       to x, which is the count of the first half-period. */
+    uint32_t u32wc = ((uint32_t)i32reg - *pi32acc) >> 24U;
+    *pi32acc += (u32wc << 24U) - i32reg;
+    for(int i = 0; i < n; ++i)
+    {
+        const uint sm = apDCO[i]->_ism;
+        pio_sm_clear_fifos(pio, sm);
+        pio_sm_restart(pio, sm);
+        pio_sm_set_clkdiv_int_frac(pio, sm, pDCO->_u16_clkdiv, 0);
+        pio_sm_exec(pio, sm, pio_encode_set(pio_pins, 0));
+        pio_sm_put(pio, sm, u32wc + pu32delay[i]);
+        pio_sm_exec(pio, sm, pio_encode_pull(false, false));
+        pio_sm_exec(pio, sm, pio_encode_mov(pio_x, pio_osr));
+        pio_sm_put(pio, sm, u32wc);
+        pio_sm_exec(pio, sm, pio_encode_pull(false, false));
+        pio_sm_exec(pio, sm, pio_encode_mov(pio_y, pio_osr));
+        pio_sm_exec(pio, sm, pio_encode_out(pio_null, 32));
+        pio_sm_exec(pio, sm, pio_encode_jmp(pDCO->_offset + dco_offset_LOOP0));
+    }
+
+    uint32_t u32words = 1;
+    for(; u32words < pDCO->_u8_fifo_depth; ++u32words)
+    {
+        u32wc = ((uint32_t)i32reg - *pi32acc) >> 24U;
+        for(int i = 0; i < n; ++i)
+        {
+            pio_sm_put(pio, apDCO[i]->_ism, u32wc);
+        }
+        *pi32acc += (u32wc << 24U) - i32reg;
+    }
+
+    pio->fdebug = (u32mask << PIO_FDEBUG_TXSTALL_LSB) | (u32mask << PIO_FDEBUG_TXOVER_LSB);
+    pio_enable_sm_mask_in_sync(pio, u32mask);
+
+    return u32words;
+}
+
+/// @brief Main worker task of phase group of PioDCOPhaseGroupInit. The SMs run
+/// @brief in lockstep on the same words of one PLL, so their offsets are kept
+/// @brief exactly; it is time critical, so it ought to be run on the dedicated
+/// @brief pi pico core.
+/// @param apDCO Array of ptrs to DCO contexts of group, the first one first.
+/// @param n A count of DCOs.
+/// @return No return. It spins forever.
+/// @remark The group is synced again when a phase delay or the PIO CLK
+/// @remark divider changes, on a FIFO flush, on key down, on start and if an
+/// @remark SM has lost the lockstep by an underrun. The freq changes which
+/// @remark keep the delays within 3/4 PIO CLK cycle, e.g. the tones, are
+/// @remark continuous. The word rate is half the freq, each word goes to n SMs.
+void RAM (PioDCOWorkerPhased)(PioDco *apDCO[], int n)
+{
+    assert_(n > 1 && n <= PIODCO_MAX_OUTPUTS);
+
+    PioDco *pDCO = apDCO[0];
+    register PIO pio = pDCO->_pio;
+    register uint sm = pDCO->_ism;
+    uint32_t u32mask = 0;
+    volatile uint32_t *apu32txf[PIODCO_MAX_OUTPUTS];
+    for(int i = 0; i < n; ++i)
+    {
+        u32mask |= 1U << apDCO[i]->_ism;
+        apu32txf[i] = &pio->txf[apDCO[i]->_ism];
+    }
+    const uint32_t u32lost = (u32mask << PIO_FDEBUG_TXSTALL_LSB) | (u32mask << PIO_FDEBUG_TXOVER_LSB);
+    const uint32_t u32full = u32mask << PIO_FSTAT_TXFULL_LSB;
+
+    uint32_t au32delay[PIODCO_MAX_OUTPUTS] = { 0 };
+    int32_t i32acc_error = 0;
+    int32_t i32reg = 0;
+    uint32_t u32seq = ~pDCO->_u32_freq_seq;
+    uint16_t u16clkdiv = 0;
+    int is_enabled = NO;
+    int is_sync = NO;
+    for(uint32_t u32word = 0;;)
+    {
+        if(__builtin_expect(pDCO->_u32_freq_seq != u32seq, 0))
+        {
+            PioDCOPollFreq(pDCO, &u32seq, &i32reg, NULL, &i32acc_error, u32word);
+            const int is_moved = PioDCOPhaseGroupDelays(apDCO, n, i32reg, au32delay);
+            is_sync = is_sync && !is_moved && !pDCO->_u8_fifo_flush
+                      && u16clkdiv == pDCO->_u16_clkdiv && !(pio->fdebug & u32lost);
+            is_enabled = pDCO->_is_enabled;
+            if(!is_enabled)
+            {
+                pio_set_sm_mask_enabled(pio, u32mask, false);
+                is_sync = NO;
+            }
+        }
+
+        if(!is_sync)
+        {
+            if(is_enabled)
+            {
+                u32word += PioDCOPhaseGroupSync(apDCO, n, u32mask, au32delay, i32reg, &i32acc_error);
+                u16clkdiv = pDCO->_u16_clkdiv;
+                is_sync = YES;
+            }
+            continue;
+        }
+
+        /* The delayed SMs pull a word later than the first one. */
+        if(pio_sm_get_tx_fifo_level(pio, sm) >= pDCO->_u8_fifo_depth || (pio->fstat & u32full))
+        {
+            continue;
+        }
+
+        if(__builtin_expect(!(u32word & (PIODCO_FIFO_SAMPLE_WORDS - 1)), 0))
+        {
+            is_sync = !(pio->fdebug & u32lost);
+            PioDCOSampleFifo(pDCO, u32word);
+            if(!is_sync)
+            {
+                continue;
+            }
+        }
+
+        const register uint32_t u32wc = ((uint32_t)i32reg - i32acc_error) >> 24U;
+        for(int i = 0; i < n; ++i)
+        {
+            *apu32txf[i] = u32wc;
+        }
+        i32acc_error += (u32wc << 24U) - i32reg;
+        ++u32word;
+    }
 }
 
 /// @brief Main worker task of DCO. It is time critical, so it ought to be run on
@@ -217,10 +2213,12 @@ void RAM (PioDCOWorker)(PioDco *pDCO)
     register int32_t i32acc_error = 0;
     register uint32_t *preg32 = pDCO->_ui32_pioreg;
     register uint8_t *pu8reg = (uint8_t *)preg32;
+    int32_t i32reg = 0;
+    uint32_t u32seq = ~pDCO->_u32_freq_seq;
 
-    for(;;)
+    for(uint32_t u32word = 0;; u32word += 8)
     {
-        const register int32_t i32reg = si32precise_cycles;
+        PioDCOPollFreq(pDCO, &u32seq, &i32reg, NULL, NULL, u32word);
         /* RPix: Load the next precise value of CPU CLK cycles per DCO cycle,
            scaled by 2^24. It yields about 24 millihertz resolution at @10MHz
            DCO frequency. */
@@ -240,6 +2238,7 @@ void RAM (PioDCOWorker)(PioDco *pDCO)
             pu8reg[i] = i32wc - PIOASM_DELAY_CYCLES;
         }
 
+        PioDCOSampleFifo(pDCO, u32word);
         dco_program_puts(pio, sm, preg32);
     }
 }
@@ -267,3 +2266,141 @@ void PioDCOSetMode(PioDco *pdco, enum PioDcoMode emode)
             break;
     }
 }
+
+/// @brief Selects the engine which feeds PIO SM. It is used by the DCO core
+/// @brief to choose the worker task, so it ought to be set before it starts.
+/// @param pdco Ptr to DCO context.
+/// @param eengine Desired engine.
+/// @remark On RP2350 the bitstream engine uses HSTX instead of PIO, if the
+/// @remark GPIO of DCO is one of HSTX. It doubles the bit rate.
+void PioDCOSetEngine(PioDco *pdco, enum PioDcoEngine eengine)
+{
+    assert_(pdco);
+    assert_(eengine < eDCOENGINE_NUM);
+
+    pdco->_engine = eengine;
+
+#if PICO_RP2350
+    /* The bitstream goes out by HSTX at twice its CLK, if the pin has it. */
+    const bool is_hstx = eDCOENGINE_BITSTREAM == eengine && pdco->_gpio >= PIODCO_HSTX_FIRST_GPIO
+        && pdco->_gpio < PIODCO_HSTX_FIRST_GPIO + PIODCO_HSTX_GPIOS;
+    pdco->_u32_hstx_bit_hz = is_hstx ? 2U * clock_get_hz(clk_hstx) : 0;
+#endif
+}
+
+/// @brief Sets the count of adjacent GPIOs, from the one of DCO on, which are
+/// @brief driven in parallel, and their drive strength. More pins and a higher
+/// @brief strength lower the output impedance, so the RF power into a load rises.
+/// @param pdco Ptr to DCO context.
+/// @param npins The count of GPIOs, 1..PIODCO_MAX_PINS.
+/// @param edrive The drive strength of each GPIO.
+/// @remark The slew rate is set to fast. The SM is configured again, so it
+/// @remark ought to be set before the worker starts. The bitstream engine
+/// @remark drives the first GPIO only.
+void PioDCOSetPins(PioDco *pdco, int npins, enum gpio_drive_strength edrive)
+{
+    assert_(pdco);
+    assert_(npins > 0 && npins <= PIODCO_MAX_PINS);
+
+    for(int i = 0; i < npins; ++i)
+    {
+        const uint gpio = pdco->_gpio + i;
+        if(i)
+        {
+            gpio_init(gpio);
+            pio_gpio_init(pdco->_pio, gpio);
+        }
+        gpio_set_drive_strength(gpio, edrive);
+        gpio_set_slew_rate(gpio, GPIO_SLEW_RATE_FAST);
+    }
+    pio_sm_set_consecutive_pindirs(pdco->_pio, pdco->_ism, pdco->_gpio, npins, true);
+
+    pdco->_u8_pins = npins;
+    PioDCOConfigSM(pdco);
+}
+
+/// @brief Sets the odd harmonic of DCO output to be used on air. The freq given
+/// @brief to PioDCOSetFreq is that of harmonic then. It takes effect with the
+/// @brief next PioDCOSetFreq.
+/// @param pdco Ptr to DCO context.
+/// @param n The harmonic 1, 3, 5 or 7. 0 selects the lowest one which keeps
+/// @param n the fundamental below CLK/PIODCO_HARMONIC_CLK_RATIO.
+/// @remark The 50% duty of DCO is optimal for odd harmonics already, the
+/// @remark amplitude of N-th one is 1/N of the fundamental (-9.5 dB for 3rd).
+void PioDCOSetHarmonic(PioDco *pdco, int n)
+{
+    assert_(pdco);
+    assert_(n >= 0 && n <= PIODCO_MAX_HARMONIC && (!n || (n & 1)));
+
+    pdco->_u8_harmonic = n;
+}
+
+/// @brief Sets the mark to period ratio of DCO output. It takes effect with the
+/// @brief next PioDCOSetFreq, if the freq is in the range of dco16 u-program;
+/// @brief dco u-program always generates a 50% square wave.
+/// @param pdco Ptr to DCO context.
+/// @param duty_permille The duty, 1e-3, PIODCO_DUTY_MIN..MAX_PERMILLE.
+/// @remark The edges are kept by the PLL, so fractional duty is dithered.
+void PioDCOSetDuty(PioDco *pdco, int duty_permille)
+{
+    assert_(pdco);
+    assert_(duty_permille >= PIODCO_DUTY_MIN_PERMILLE && duty_permille <= PIODCO_DUTY_MAX_PERMILLE);
+
+    pdco->_u16_duty_permille = duty_permille;
+}
+
+/// @brief Sets the latency of freq changes of CPU and timed engines. A new freq
+/// @brief reaches the pin after the words queued to SM, up to (depth + 2)
+/// @brief words, so fewer words are queued, or they are dropped on a change
+/// @brief and it takes 2 words regardless of depth. It ought to be set before
+/// @brief the worker starts.
+/// @param pdco Ptr to DCO context.
+/// @param fifo_depth The max words queued, 1..PIODCO_FIFO_DEPTH.
+/// @param flush Whether the queued words are dropped on a freq change.
+/// @remark The shallower FIFO, the less of worker stall it absorbs, check
+/// @remark the FIFO underruns. The flush is glitch-free, the word SM runs
+/// @remark completes, but SM might wait a few cycles for the new one.
+void PioDCOSetLatency(PioDco *pdco, int fifo_depth, int flush)
+{
+    assert_(pdco);
+    assert_(fifo_depth >= 1 && fifo_depth <= PIODCO_FIFO_DEPTH);
+
+    pdco->_u8_fifo_depth = fifo_depth;
+    pdco->_u8_fifo_flush = flush ? YES : NO;
+}
+
+/// @brief Sets noise shaping of MASH engine. It takes effect with the next
+/// @brief PioDCOSetFreq.
+/// @param pdco Ptr to DCO context.
+/// @param order The order of MASH, 1..3. The output word deviates from the
+/// @param order integer cycles by -(2^(order-1)-1)..2^(order-1).
+/// @param dither Whether LFSR dither is added.
+/// @remark The auto harmonic is raised for the word to stay above zero, the
+/// @remark order is lowered where the harmonic can't be.
+void PioDCOSetNoiseShaping(PioDco *pdco, int order, int dither)
+{
+    assert_(pdco);
+    assert_(order >= 1 && order <= 3);
+
+    pdco->_u8_mash_order = order;
+    pdco->_u8_dither = dither ? YES : NO;
+}
+
+/// @brief Calculates the MASH order the engine runs a freq at, the way
+/// @brief PioDCOSetFreq chooses it. It is for checking settings.
+/// @param ui32_clkfreq_hz The CPU CLK freq [Hz].
+/// @param harmonic The harmonic set, 0 is auto.
+/// @param order The order of MASH set, 1..3.
+/// @param ui32_frq_hz The freq [Hz].
+/// @return The order, it is lower than the one set if the freq can't have it.
+int PioDCOCalcMASHOrder(uint32_t ui32_clkfreq_hz, int harmonic, int order, uint32_t ui32_frq_hz)
+{
+    assert_(order >= 1 && order <= 3);
+
+    const uint8_t u8harmonic = PioDCOCalcHarmonic(harmonic, PioDCOMASHMaxFundamental(ui32_clkfreq_hz, order),
+                                                  ui32_frq_hz);
+    const int64_t i64cycles = PioDCOCalcCyclesPerPi64(ui32_clkfreq_hz, u8harmonic, ui32_frq_hz, 0);
+    const uint16_t u16clkdiv = (i64cycles + INT32_MAX - 1) / INT32_MAX;
+
+    return PioDCOFitMASHOrder(PioDCODivideCycles(i64cycles, u16clkdiv), order);
+}
@@ -74,10 +74,12 @@
 #include <stdint.h>
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
 
 #include "defines.h"
 
 #include "../gpstime/GPStime.h"
+#include "../lib/spscring.h"
 
 enum PioDcoMode
 {
@@ -85,22 +87,106 @@ enum PioDcoMode
     eDCOMODE_GPS_COMPENSATED= 2 /* Internally compensated, if GPS available. */
 };
 
+enum PioDcoEngine
+{
+    eDCOENGINE_CPU = 0,         /* Core1 busy loop, PioDCOWorker2. */
+    eDCOENGINE_DMA,             /* Ping-pong DMA buffers refilled by IRQ. */
+    eDCOENGINE_PATTERN,         /* Precomputed tone patterns looped by DMA. */
+    eDCOENGINE_MASH,            /* Core1 busy loop, MASH noise shaping. */
+    eDCOENGINE_TIMED,           /* Core1 busy loop, timestamped freq queue. */
+    eDCOENGINE_BITSTREAM,       /* Rendered RF waveforms looped by DMA. */
+    eDCOENGINE_NUM
+};
+
+enum PioDcoProgram
+{
+    eDCOPROG_DCO = 0,           /* dco: a 32-bit count per 4 half-periods. */
+    eDCOPROG_DCO16,             /* dco16: a 16-bit count per half-period. */
+    eDCOPROG_BITS               /* dcobits: a bit of waveform per PIO CLK. */
+};
+
+#define PIODCO_MAX_OUTPUTS 4        /* Max DCOs, one per SM of PIO block. */
+#define PIODCO_MAX_PINS 5           /* Max GPIOs of DCO in parallel, `set` 5 bits. */
+#define PIODCO_DMA_BUF_WORDS 256    /* Words per DMA ping-pong buffer. */
+#define PIODCO_DMA_CHANS 3          /* DMA channels of DCO, the most of an engine. */
+#define PIODCO_PATTERN_TONES 4      /* Count of tone patterns of the engine. */
+#define PIODCO_PATTERN_MAX_WORDS 2048   /* Max period of a tone pattern. */
+#define PIODCO_HSTX_FIRST_GPIO 12   /* RP2350 HSTX drives GPIO 12..19. */
+#define PIODCO_HSTX_GPIOS 8
+#define PIODCO_TIMED_QUEUE_LEN 256  /* Timed commands, power of 2. */
+#define PIODCO_EDGE_HIST_BINS 8     /* Log2 bins of edge lateness, us. */
+#define PIODCO_MAX_HARMONIC 7       /* The highest odd harmonic used. */
+#define PIODCO_HARMONIC_CLK_RATIO 10    /* Auto: fundamental below CLK/10. */
+#define PIODCO_GROUP_CLK_RATIO 12   /* Auto: below CLK/(12 n) in a phase group. */
+#define PIODCO_DCO16_CLK_RATIO 32   /* dco16 is used below CLK/32 fundamental. */
+#define PIODCO_MASH_SPAN(order) (1 << ((order) - 1))  /* MASH word is n-span+1..n+span. */
+#define PIODCO_DUTY_MIN_PERMILLE 100    /* Keeps both halves above dco16 delay. */
+#define PIODCO_DUTY_MAX_PERMILLE 900
+#define PIODCO_ENV_STEPS 64         /* Steps of keying envelope ramp. */
+#define PIODCO_ENV_RAMP_US 5000     /* Duration of keying envelope ramp. */
+#define PIODCO_ENV_PWM_WRAP 1023    /* PWM resolution of envelope pin. */
+#define PIODCO_FIFO_SAMPLE_WORDS 64 /* FIFO telemetry period, power of 2. */
+#define PIODCO_FIFO_DEPTH 8         /* TX FIFO of SM joined with RX one. */
+#define PIODCO_TONE_TABLE_LEN 4     /* Tones of a transmission, e.g. WSPR. */
+
+/* Frequency published to the worker as a whole. */
 typedef struct
+{
+    int32_t _i32_precise_cycles;    /* Cycles per word to the worker. */
+    int32_t _i32_precise_mark;      /* dco16: cycles of the high half. */
+    uint32_t _ui32_frq_hz;          /* Freq, Hz. */
+    int32_t _i32_frq_millihz;       /* Freq additive shift, mHz. */
+    uint8_t _u8_program;            /* PioDcoProgram the cycles are for. */
+    uint8_t _u8_key_up;             /* Stop feeding SM, it stalls low. */
+    uint8_t _u8_mash_order;         /* MASH order which fits the freq, 0 not MASH. */
+    uint8_t _u8_harmonic_n;         /* The harmonic the cycles are for. */
+    uint16_t _u16_clkdiv;           /* PIO CLK divider the cycles are for. */
+    int32_t _i32_phase_total;       /* Sum of phase shifts, 2^24 cycles/4. */
+} PioDcoFreqDesc;
+
+/* Freq descriptors of the tones of a transmission, made in advance. */
+typedef struct
+{
+    PioDcoFreqDesc _desc[PIODCO_TONE_TABLE_LEN];        /* Ready to publish. */
+    int32_t _i32_cycles_per_pi[PIODCO_TONE_TABLE_LEN];  /* Core0 view of each. */
+    int64_t _i64_ppb;               /* GPS correction it is made with. */
+} PioDcoToneTable;
+
+/* Freq command applied by the worker when the timer passes its time. */
+typedef struct
+{
+    uint64_t _u64_time_us;          /* Timer time to apply at, us. */
+    int32_t _i32_precise_cycles;    /* Cycles per word from then on. */
+} PioDcoTimedCmd;
+
+SPSC_RING_DEFINE(PioDcoTimedRing, PioDcoTimedCmd, PIODCO_TIMED_QUEUE_LEN)
+
+typedef struct PioDco
 {
     enum PioDcoMode _mode;      /* Running mode. */
 
     PIO _pio;                   /* Worker PIO on this DCO. */
     int _gpio;                  /* Pico' GPIO for DCO output. */
+    uint8_t _u8_pins;           /* Adjacent GPIOs driven in parallel from it. */
 
     pio_sm_config _pio_sm;      /* Worker PIO parameter. */
     int _ism;                   /* Index of state maschine. */
     int _offset;                /* Worker PIO u-program offset. */
+    int _offset16;              /* The offset of dco16 u-program. */
+    int _offset_bits;           /* The offset of dcobits u-program. */
+    enum PioDcoProgram _program;    /* The u-program SM runs. */
 
     int32_t _frq_cycles_per_pi; /* CPU CLK cycles per PI. */
+    PioDcoFreqDesc _freq[2];    /* Double-buffered freq to the worker. */
+    volatile uint32_t _u32_freq_seq;    /* Publish counter, LSB selects _freq. */
+    uint16_t _u16_clkdiv;       /* PIO CLK divider, >1 on LF and MF only. */
+    uint8_t _u8_harmonic;       /* Odd harmonic to be used, 0 is auto. */
+    uint8_t _u8_harmonic_n;     /* The harmonic in use, fundamental is 1. */
+    uint16_t _u16_duty_permille;    /* Mark to period ratio of dco16, 1e-3. */
 
     uint32_t _ui32_pioreg[8];   /* Shift register to PIO. */
 
- //   uint32_t _clkfreq_hz;       /* CPU CLK freq, Hz. */
+    uint32_t _clkfreq_hz;       /* CPU CLK freq, Hz. */
 
     GPStimeContext *_pGPStime;  /* Ptr to GPS time context. */
 
@@ -108,18 +194,106 @@ typedef struct
     int32_t _ui32_frq_millihz;  /* Working freq additive shift, mHz. */
     int _is_enabled;
 
+    enum PioDcoEngine _engine;  /* The engine which feeds PIO SM. */
+    int _dma_chan[PIODCO_DMA_CHANS];    /* Ping-pong, or pattern data, control and select. */
+    int32_t _i32acc_error;      /* PLL accumulated error of DMA engine. */
+    uint32_t _ui32_dmabuf[2][PIODCO_DMA_BUF_WORDS]; /* Ping-pong buffers. */
+
+    uint16_t _u16_pattern_len[PIODCO_PATTERN_TONES];    /* Period, words. */
+    uint32_t _u32_pattern_ctrl[PIODCO_PATTERN_TONES][2];    /* {count, address}. */
+    const uint32_t * volatile _pu32_pattern_ctrl;       /* The one DMA reloads. */
+    int32_t _i32_pattern_err_millihz[PIODCO_PATTERN_TONES]; /* Freq error. */
+    uint32_t _u32_hstx_bit_hz;  /* Bit rate of HSTX bitstream, 0 uses PIO. */
+
+    uint8_t _u8_mash_order;     /* Order of MASH noise shaping, 1..3. */
+    uint8_t _u8_mash_run;       /* The order MASH worker runs, core1. */
+    uint8_t _u8_dither;         /* Add LFSR dither to MASH input. */
+
+    uint32_t _u32_fed_words;    /* Words refilled so far by DMA engine. */
+    volatile uint32_t _u32_published_us;    /* Time of last publish, us. */
+    volatile uint32_t _u32_applied_seq;     /* The last seq applied by worker. */
+    volatile uint32_t _u32_applied_word;    /* Word index it took effect at. */
+    volatile uint32_t _u32_applied_us;      /* Time it took effect, us. */
+
+    PioDcoTimedRing _timed;             /* Core0 to worker queue. */
+    volatile uint8_t _u8_timed_flush;   /* Core0 asks worker to drop queue. */
+    uint32_t _u32_edge_hist[PIODCO_EDGE_HIST_BINS]; /* 0,1,2-3,4-7..us late. */
+    uint32_t _u32_edge_late_max_us;     /* The worst edge lateness, us. */
+
+    volatile uint32_t _u32_fifo_stalls; /* Samples with SM stalled on empty FIFO. */
+    volatile uint32_t _u32_fifo_overs;  /* Samples with a put to full FIFO. */
+    uint32_t _u32_fifo_stalls_tx0;      /* The stalls at the start of TX. */
+    uint32_t _u32_fifo_overs_tx0;       /* The overs at the start of TX. */
+    volatile uint8_t _u8_fifo_min_level;    /* The lowest FIFO level of TX. */
+    volatile uint8_t _u8_fifo_min_ever;     /* The lowest FIFO level since boot. */
+    volatile uint8_t _u8_fifo_reset;        /* Core0 asks worker to restart TX level. */
+    uint8_t _u8_fifo_depth;     /* Max words queued to SM, 1..8. */
+    uint8_t _u8_fifo_flush;     /* Drop the queued words on a freq change. */
+
+    uint8_t _u8_key_up;         /* Keyed up by PioDCOKeyUp, core0 view. */
+    int32_t _i32_phase_total;   /* Sum of phase shifts, core0 view. */
+    int32_t _i32_phase_applied; /* The part of it applied by worker. */
+    int _env_gpio;              /* PWM pin of PA bias envelope, -1 none. */
+    int _env_dma_chan;          /* DMA channel feeding envelope PWM. */
+    int _env_dma_timer;         /* DMA timer pacing envelope steps. */
+    alarm_id_t _env_alarm;      /* Key up at the end of the fall ramp. */
+
+    struct PioDco *_pgroup;     /* The first DCO of phase group, or NULL. */
+    struct PioDco *_apgroup[PIODCO_MAX_OUTPUTS];    /* The first one: its group. */
+    uint8_t _u8_group_n;        /* The first one: count of DCOs of group. */
+    int16_t _i16_phase_offset;  /* Offset to the first DCO, 1/1000 cycle. */
+    volatile uint32_t _u32_phase_delay; /* The offset applied, PIO CLK cycles. */
+
 } PioDco;
 
 int PioDCOInit(PioDco *pdco, int gpio);
 int PioDCOSetFreq(PioDco *pdco, uint32_t u32_frq_hz, int32_t u32_frq_millihz);
+uint32_t PioDCOGetFreqDesc(const PioDco *pdco, PioDcoFreqDesc *pdesc);
+void PioDCOToneTableBuild(const PioDco *pdco, PioDcoToneTable *ptt, uint32_t ui32_frq_hz, 
+                          int32_t i32_step_millihz);
+int PioDCOToneTableIsStale(const PioDco *pdco, const PioDcoToneTable *ptt);
+void RAM (PioDCOToneSelect)(PioDco *pdco, const PioDcoToneTable *ptt, int itone);
 int32_t PioDCOGetFreqShiftMilliHertz(const PioDco *pdco, uint64_t u64_desired_frq_millihz);
 
 void PioDCOStart(PioDco *pdco);
 void PioDCOStop(PioDco *pdco);
+void PioDCOKeyDown(PioDco *pdco);
+void PioDCOKeyUp(PioDco *pdco);
+int PioDCOPhaseShift(PioDco *pdco, int32_t i32_millicycles);
+int PioDCOPhaseGroupInit(PioDco *apdco[], int n);
+void PioDCOSetPhaseOffset(PioDco *pdco, int32_t i32_millicycles);
+int32_t PioDCOGetPhaseOffset(const PioDco *pdco);
+void PioDCOFifoStatsStart(PioDco *pdco);
+int PioDCOEnvelopeInit(PioDco *pdco, int gpio);
 
 void PioDCOSetMode(PioDco *pdco, enum PioDcoMode emode);
+void PioDCOSetEngine(PioDco *pdco, enum PioDcoEngine eengine);
+void PioDCOSetPins(PioDco *pdco, int npins, enum gpio_drive_strength edrive);
+void PioDCOSuspend(PioDco *pdco);
+void PioDCOSetClock(PioDco *pdco);
+void PioDCOSetNoiseShaping(PioDco *pdco, int order, int dither);
+int PioDCOCalcMASHOrder(uint32_t ui32_clkfreq_hz, int harmonic, int order, uint32_t ui32_frq_hz);
+void PioDCOSetHarmonic(PioDco *pdco, int n);
+void PioDCOSetDuty(PioDco *pdco, int duty_permille);
+void PioDCOSetLatency(PioDco *pdco, int fifo_depth, int flush);
+
+int PioDCODMAInit(PioDco *pdco);
+
+int PioDCOPatternInit(PioDco *pdco);
+int PioDCOPatternBuild(PioDco *pdco, int itone, uint32_t ui32_frq_hz, int32_t i32_frq_millihz);
+int32_t PioDCOPatternError(const PioDco *pdco, uint32_t ui32_frq_hz, int32_t i32_frq_millihz);
+void RAM (PioDCOPatternSelect)(PioDco *pdco, int itone);
+
+int PioDCOTimedPush(PioDco *pdco, uint64_t u64_time_us, uint32_t ui32_frq_hz, int32_t i32_frq_millihz);
+void PioDCOTimedFlush(PioDco *pdco);
+void PioDCOTimedClearHistogram(PioDco *pdco);
 
 void RAM (PioDCOWorker)(PioDco *pDCO);
 void RAM (PioDCOWorker2)(PioDco *pDCO);
+void RAM (PioDCOWorkerDMA)(PioDco *pDCO);
+void RAM (PioDCOWorkerPattern)(PioDco *pDCO);
+void RAM (PioDCOWorkerMASH)(PioDco *pDCO);
+void RAM (PioDCOWorkerTimed)(PioDco *pDCO);
+void RAM (PioDCOWorkerPhased)(PioDco *apDCO[], int n);
 
 #endif
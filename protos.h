@@ -1,7 +1,13 @@
 #ifndef PROTOS_H_
 #define PROTOS_H_
 
-void InitPicoHW(void);
+#include <stdint.h>
+
+uint32_t InitPicoHW(uint32_t sysclk_mhz);
+uint32_t InitSwitchSysClock(uint32_t sysclk_mhz);
 void Core1Entry(void);
+void Core1Suspend(void);
+void Core1Resume(void);
+int Core1MeasureCarrier(uint32_t u32_frq_hz, int gate_s, int64_t *pi64_millihz, int *pharmonic);
 
 #endif
@@ -0,0 +1,17 @@
+/* Host stand-in of the pico SDK header, see hostsdk.h. */
+#include "hostsdk.h"
+
+typedef struct
+{
+    volatile uint32_t csr;
+    volatile uint32_t bit[8];
+    volatile uint32_t expand_shift;
+    volatile uint32_t expand_tmds;
+} hstx_ctrl_hw_t;
+extern hstx_ctrl_hw_t *hstx_ctrl_hw;
+#define HSTX_CTRL_CSR_EN_BITS 0x1u
+#define HSTX_CTRL_CSR_SHIFT_LSB 16
+#define HSTX_CTRL_CSR_N_SHIFTS_LSB 8
+#define HSTX_CTRL_CSR_CLKDIV_LSB 28
+#define HSTX_CTRL_BIT0_SEL_P_LSB 0
+#define HSTX_CTRL_BIT0_SEL_N_LSB 8
@@ -0,0 +1,5 @@
+/* Host stand-in of the pico SDK header, see hostsdk.h. */
+#include "hostsdk.h"
+
+typedef struct { volatile uint32_t stat; volatile uint32_t fifo; } hstx_fifo_hw_t;
+extern hstx_fifo_hw_t *hstx_fifo_hw;
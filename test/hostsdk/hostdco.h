@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  hostdco.h - Waveform model of the dco u-programs for the host tests.
+//
+//  DESCRIPTION
+//      It turns the words captured from a DCO worker into the times of the
+//      edges SM would make of them, in PIO CLK cycles, and measures the phase
+//      error of the edges against the ideal ones of a freq. It is to be
+//      included after piodco.c, which has the delays of the u-programs.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef HOSTDCO_H_
+#define HOSTDCO_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Phase error of edges, degrees of RF. */
+typedef struct
+{
+    double _rms_deg;
+    double _peak_deg;
+} HostPhaseError;
+
+/// @brief Makes the edges of dco u-program: a word times 4 half-periods
+/// @brief of word + PIOASM_DELAY_CYCLES cycles each.
+/// @param pu32words Ptr to the words.
+/// @param nwords A count of words.
+/// @param pu64edges Ptr to 4 * nwords edge times, cycles.
+/// @return A count of edges.
+static size_t HostDcoEdges(const uint32_t *pu32words, size_t nwords, uint64_t *pu64edges)
+{
+    uint64_t u64t = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < nwords; ++i)
+    {
+        for(int h = 0; h < 4; ++h)
+        {
+            u64t += pu32words[i] + PIOASM_DELAY_CYCLES;
+            pu64edges[n++] = u64t;
+        }
+    }
+
+    return n;
+}
+
+/// @brief Makes the edges of dco16 u-program: a word times the low half of
+/// @brief period by its low 16 bits and the high one by the upper 16 bits,
+/// @brief each lasts count + PIOASM_DCO16_DELAY_CYCLES cycles.
+/// @param pu32words Ptr to the words.
+/// @param nwords A count of words.
+/// @param pu64edges Ptr to 2 * nwords edge times, cycles.
+/// @return A count of edges, the rising ones are odd.
+static size_t HostDco16Edges(const uint32_t *pu32words, size_t nwords, uint64_t *pu64edges)
+{
+    uint64_t u64t = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < nwords; ++i)
+    {
+        u64t += (pu32words[i] & 0xFFFFU) + PIOASM_DCO16_DELAY_CYCLES;
+        pu64edges[n++] = u64t;
+        u64t += (pu32words[i] >> 16) + PIOASM_DCO16_DELAY_CYCLES;
+        pu64edges[n++] = u64t;
+    }
+
+    return n;
+}
+
+/// @brief Measures the phase error of edges against the ones of a freq, the
+/// @brief constant part being the start of waveform.
+/// @param pu64edges Ptr to the edge times, cycles.
+/// @param nedges A count of edges.
+/// @param step The edges of which to measure, e.g. 2 for the rising ones.
+/// @param cycles_per_pi The cycles per PI of the freq.
+/// @return The error.
+static HostPhaseError HostEdgeError(const uint64_t *pu64edges, size_t nedges, size_t step,
+                                   double cycles_per_pi)
+{
+    double mean = 0.0;
+    size_t n = 0;
+    for(size_t k = step - 1; k < nedges; k += step, ++n)
+    {
+        mean += (double)pu64edges[k] - (k + 1) * cycles_per_pi;
+    }
+    mean /= n;
+
+    HostPhaseError err = { 0.0, 0.0 };
+    for(size_t k = step - 1; k < nedges; k += step)
+    {
+        const double e = ((double)pu64edges[k] - (k + 1) * cycles_per_pi - mean) * 180.0 / cycles_per_pi;
+        err._rms_deg += e * e;
+        err._peak_deg = fabs(e) > err._peak_deg ? fabs(e) : err._peak_deg;
+    }
+    err._rms_deg = sqrt(err._rms_deg / n);
+
+    return err;
+}
+
+#endif
@@ -0,0 +1,685 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  hostsdk.c - Host stand-ins of pico SDK for the host tests.
+//
+//  DESCRIPTION
+//      The registers are static memory, DMA channels only keep what they
+//      were set to, alarms run when a test asks for the next one. The words
+//      put to SMs of pio0 are captured, and so are the ones stored to TXF
+//      directly, when the worker next checks a FIFO level; a test might ask
+//      the capture to longjmp back once an SM has got enough words, so that
+//      an endless worker loop can be run on the host as it is.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "hostsdk.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "hardware/structs/hstx_ctrl.h"
+#include "hardware/structs/hstx_fifo.h"
+#include "../../pico-hf-oscillator/lib/utility.h"
+
+/* The inline functions of utility.h need an external definition. */
+extern uint64_t GetUptime64(void);
+extern uint32_t GetTime32(void);
+extern uint32_t PicoU64timeToSeconds(uint64_t u64tm);
+extern uint32_t DecimalStr2ToNumber(const char *p);
+extern void PRN32(uint32_t *val);
+
+#define HOST_MAX_ALARMS 16
+
+typedef struct
+{
+    const volatile void *_pread;    /* Read address of channel. */
+    volatile void *_pwrite;         /* Write address of channel. */
+    uint32_t _u32_count;            /* Transfer count of channel. */
+    uint32_t _u32_ctrl;             /* CTRL of the config it was configured with. */
+    int _is_started;                /* Started by the code under test. */
+    int _is_claimed;
+} HostDmaChannel;
+
+typedef struct
+{
+    alarm_callback_t _pcallback;
+    void *_puser;
+    uint64_t _u64_at_us;
+    int _is_pending;
+} HostAlarm;
+
+static pio_hw_t sPio[2];
+static dma_hw_t sDma;
+static timer_hw_t sTimer;
+static pwm_hw_t sPwm;
+static hstx_ctrl_hw_t sHstxCtrl;
+static hstx_fifo_hw_t sHstxFifo;
+
+pio_hw_t *pio0 = &sPio[0], *pio1 = &sPio[1];
+dma_hw_t *dma_hw = &sDma;
+timer_hw_t *timer_hw = &sTimer;
+pwm_hw_t *pwm_hw = &sPwm;
+hstx_ctrl_hw_t *hstx_ctrl_hw = &sHstxCtrl;
+hstx_fifo_hw_t *hstx_fifo_hw = &sHstxFifo;
+uart_inst_t *uart0, *uart1;
+
+jmp_buf gHostStop;
+uint32_t gHostClkSysHz = 125000000;
+uint32_t gHostClkHstxHz = 150000000;
+irq_handler_t gHostDmaIrq1;
+uint32_t gHostIrqEnabled;
+void (*gHostOnPut)(uint sm, uint32_t word);
+void (*gHostOnIdle)(void);
+
+static uint64_t su64TimeUs;
+static uint32_t sui32SmClaimed[2];
+static int siProgramEnd[2];
+static uint32_t sui32Words[4][HOST_PIO_CAPTURE_WORDS];
+static uint32_t sui32Rx[2][4][HOST_PIO_RX_FIFO_DEPTH];
+static uint suRxLevel[2][4];
+static size_t suSyncs;
+static size_t suWords[4];
+static size_t suStopAt[4];
+static HostDmaChannel sDmaChan[16];
+static int siDmaTimers;
+static HostAlarm sAlarm[HOST_MAX_ALARMS];
+static uint32_t sui32Gpio;
+
+void HostFail(const char *pfile, int line, const char *pexpr)
+{
+    fprintf(stderr, "%s:%d: check failed: %s\n", pfile, line, pexpr);
+    exit(1);
+}
+
+void assert_(bool val)
+{
+    if(!val)
+    {
+        fprintf(stderr, "assert_ failed\n");
+        abort();
+    }
+}
+
+void HostReset(void)
+{
+    memset(sPio, 0, sizeof(sPio));
+    for(int sm = 0; sm < 4; ++sm)
+    {
+        pio0->txf[sm] = HOST_PIO_TXF_NONE;
+    }
+    memset(&sDma, 0, sizeof(sDma));
+    memset(sDmaChan, 0, sizeof(sDmaChan));
+    memset(sAlarm, 0, sizeof(sAlarm));
+    memset(suWords, 0, sizeof(suWords));
+    memset(suStopAt, 0, sizeof(suStopAt));
+    memset(sui32SmClaimed, 0, sizeof(sui32SmClaimed));
+    memset(siProgramEnd, 0, sizeof(siProgramEnd));
+    memset(suRxLevel, 0, sizeof(suRxLevel));
+    suSyncs = 0;
+    siDmaTimers = 0;
+    gHostOnPut = NULL;
+    gHostOnIdle = NULL;
+    gHostIrqEnabled = 0;
+    HostSetTimeUs(0);
+}
+
+void HostSetTimeUs(uint64_t u64us)
+{
+    su64TimeUs = u64us;
+    sTimer.timerawl = sTimer.timelr = (uint32_t)u64us;
+    sTimer.timerawh = sTimer.timehr = (uint32_t)(u64us >> 32);
+}
+
+void HostPioCaptureStop(int sm, size_t nwords)
+{
+    suStopAt[sm] = nwords;
+}
+
+size_t HostPioCaptured(int sm, const uint32_t **ppwords)
+{
+    if(ppwords)
+    {
+        *ppwords = sui32Words[sm];
+    }
+    return suWords[sm] < HOST_PIO_CAPTURE_WORDS ? suWords[sm] : HOST_PIO_CAPTURE_WORDS;
+}
+
+size_t HostPioSyncs(void)
+{
+    return suSyncs;
+}
+
+int HostPioRxPush(PIO pio, uint sm, uint32_t word)
+{
+    uint *plevel = &suRxLevel[pio_get_index(pio)][sm];
+    if(HOST_PIO_RX_FIFO_DEPTH == *plevel)
+    {
+        return 0;
+    }
+    sui32Rx[pio_get_index(pio)][sm][(*plevel)++] = word;
+    return 1;
+}
+
+const volatile void *HostDmaReadAddr(int chan)
+{
+    return sDmaChan[chan]._pread;
+}
+
+volatile void *HostDmaWriteAddr(int chan)
+{
+    return sDmaChan[chan]._pwrite;
+}
+
+uint32_t HostDmaTransCount(int chan)
+{
+    return sDmaChan[chan]._u32_count;
+}
+
+uint32_t HostDmaCtrl(int chan)
+{
+    return sDmaChan[chan]._u32_ctrl;
+}
+
+int HostDmaStarted(int chan)
+{
+    return sDmaChan[chan]._is_started;
+}
+
+/* Runs the next pending alarm due by a time, if any. */
+static int HostAlarmRunBy(uint64_t u64us)
+{
+    int inext = -1;
+    for(int i = 0; i < HOST_MAX_ALARMS; ++i)
+    {
+        if(sAlarm[i]._is_pending && (inext < 0 || sAlarm[i]._u64_at_us < sAlarm[inext]._u64_at_us))
+        {
+            inext = i;
+        }
+    }
+    if(inext < 0 || sAlarm[inext]._u64_at_us > u64us)
+    {
+        return 0;
+    }
+
+    HostAlarm *palarm = &sAlarm[inext];
+    HostSetTimeUs(palarm->_u64_at_us);
+    palarm->_is_pending = 0;
+    const int64_t i64next = palarm->_pcallback(inext + 1, palarm->_puser);
+    if(i64next > 0)
+    {
+        palarm->_u64_at_us += i64next;
+        palarm->_is_pending = 1;
+    }
+    return 1;
+}
+
+int HostAlarmRunNext(void)
+{
+    return HostAlarmRunBy(UINT64_MAX);
+}
+
+int HostAlarmRunUntil(uint64_t u64us)
+{
+    int n = 0;
+    while(HostAlarmRunBy(u64us))
+    {
+        ++n;
+    }
+    HostSetTimeUs(u64us);
+    return n;
+}
+
+/* PIO */
+int pio_add_program(PIO pio, const pio_program_t *program)
+{
+    const int ipio = pio_get_index(pio);
+    const int offset = siProgramEnd[ipio];
+    siProgramEnd[ipio] += program->length;
+    return offset;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+    uint32_t *pclaimed = &sui32SmClaimed[pio_get_index(pio)];
+    for(int sm = 0; sm < 4; ++sm)
+    {
+        if(!(*pclaimed & (1U << sm)))
+        {
+            *pclaimed |= 1U << sm;
+            return sm;
+        }
+    }
+    assert_(!required);
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm)
+{
+    sui32SmClaimed[pio_get_index(pio)] &= ~(1U << sm);
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+    pio_set_sm_mask_enabled(pio, 1U << sm, enabled);
+}
+
+void pio_enable_sm_mask_in_sync(PIO pio, uint32_t mask)
+{
+    ++suSyncs;
+    pio->ctrl |= mask;
+}
+
+void pio_set_sm_mask_enabled(PIO pio, uint32_t mask, bool enabled)
+{
+    pio->ctrl = enabled ? pio->ctrl | mask : pio->ctrl & ~mask;
+}
+
+/* Captures a word to SM of pio0. */
+static void HostPioCapture(uint sm, uint32_t data)
+{
+    if(suWords[sm] < HOST_PIO_CAPTURE_WORDS)
+    {
+        sui32Words[sm][suWords[sm]] = data;
+    }
+    ++suWords[sm];
+    if(gHostOnPut)
+    {
+        gHostOnPut(sm, data);
+    }
+    if(suStopAt[sm] && suWords[sm] >= suStopAt[sm])
+    {
+        suStopAt[sm] = 0;
+        longjmp(gHostStop, 1);
+    }
+}
+
+/* Captures the words stored to TXF registers of pio0 directly, as the phase
+   group worker does. They are seen when the worker checks a FIFO level. */
+static void HostPioCaptureStores(void)
+{
+    for(uint sm = 0; sm < 4; ++sm)
+    {
+        const uint32_t data = pio0->txf[sm];
+        if(HOST_PIO_TXF_NONE != data)
+        {
+            pio0->txf[sm] = HOST_PIO_TXF_NONE;
+            HostPioCapture(sm, data);
+        }
+    }
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data)
+{
+    if(pio != pio0)
+    {
+        pio->txf[sm] = data;
+        return;
+    }
+    HostPioCaptureStores();
+    HostPioCapture(sm, data);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+    pio_sm_put(pio, sm, data);
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm)
+{
+    uint *plevel = &suRxLevel[pio_get_index(pio)][sm];
+    uint32_t *pfifo = sui32Rx[pio_get_index(pio)][sm];
+    if(*plevel)
+    {
+        pio->rxf[sm] = pfifo[0];
+        memmove(pfifo, pfifo + 1, --*plevel * sizeof(uint32_t));
+    }
+    return pio->rxf[sm];
+}
+
+uint32_t pio_sm_get_blocking(PIO pio, uint sm)
+{
+    return pio_sm_get(pio, sm);
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) { return false; }
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) { return true; }
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) { return !suRxLevel[pio_get_index(pio)][sm]; }
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm)
+{
+    if(pio == pio0)
+    {
+        HostPioCaptureStores();
+    }
+    return 0;
+}
+
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm) { return suRxLevel[pio_get_index(pio)][sm]; }
+void pio_sm_clear_fifos(PIO pio, uint sm) { suRxLevel[pio_get_index(pio)][sm] = 0; }
+void pio_sm_restart(PIO pio, uint sm) {}
+void pio_sm_exec(PIO pio, uint sm, uint instr) {}
+void pio_gpio_init(PIO pio, uint pin) {}
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config)
+{
+    pio->sm[sm].clkdiv = config->clkdiv;
+    pio->sm[sm].execctrl = config->execctrl;
+    pio->sm[sm].shiftctrl = config->shiftctrl;
+    pio->sm[sm].pinctrl = config->pinctrl;
+}
+
+void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac)
+{
+    pio->sm[sm].clkdiv = ((uint32_t)div_int << 16) | ((uint32_t)div_frac << 8);
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out)
+{
+    return 0;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) { return pio_get_index(pio) * 8 + sm + (is_tx ? 0 : 4); }
+uint pio_get_index(PIO pio) { return pio == pio1; }
+uint pio_encode_set(enum pio_src_dest dest, uint value) { return 0xE000 | (dest << 5) | value; }
+uint pio_encode_jmp(uint addr) { return addr; }
+uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src) { return 0xA000 | (dest << 5) | src; }
+uint pio_encode_out(enum pio_src_dest dest, uint count) { return 0x6000 | (dest << 5) | (count & 31); }
+uint pio_encode_pull(bool if_empty, bool block) { return 0x8080 | (if_empty << 6) | (block << 5); }
+
+pio_sm_config pio_get_default_sm_config(void)
+{
+    pio_sm_config c = { 1U << 16, 0, 0, 0 };
+    return c;
+}
+
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {}
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold) {}
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {}
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count) {}
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {}
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {}
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) {}
+
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac)
+{
+    c->clkdiv = ((uint32_t)div_int << 16) | ((uint32_t)div_frac << 8);
+}
+
+/* GPIO */
+void gpio_init(uint gpio) { sui32Gpio &= ~(1U << gpio); }
+void gpio_set_dir(uint gpio, bool out) {}
+void gpio_put(uint gpio, bool value) { sui32Gpio = value ? sui32Gpio | (1U << gpio) : sui32Gpio & ~(1U << gpio); }
+bool gpio_get(uint gpio) { return sui32Gpio & (1U << gpio); }
+void gpio_set_function(uint gpio, enum gpio_function fn) {}
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive) {}
+void gpio_set_slew_rate(uint gpio, enum gpio_slew_rate slew) {}
+
+/* Time and alarms */
+static alarm_id_t HostAlarmAdd(uint64_t u64at_us, alarm_callback_t callback, void *user_data)
+{
+    for(int i = 0; i < HOST_MAX_ALARMS; ++i)
+    {
+        if(!sAlarm[i]._is_pending)
+        {
+            sAlarm[i]._pcallback = callback;
+            sAlarm[i]._puser = user_data;
+            sAlarm[i]._u64_at_us = u64at_us;
+            sAlarm[i]._is_pending = 1;
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(uint max_timers)
+{
+    static int sPool;
+    return (alarm_pool_t *)&sPool;
+}
+
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback,
+                                      void *user_data, bool fire_if_past)
+{
+    return HostAlarmAdd(su64TimeUs + us, callback, user_data);
+}
+
+alarm_id_t alarm_pool_add_alarm_at(alarm_pool_t *pool, absolute_time_t time,
+                                   alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return HostAlarmAdd(time, callback, user_data);
+}
+
+bool alarm_pool_cancel_alarm(alarm_pool_t *pool, alarm_id_t alarm_id)
+{
+    return cancel_alarm(alarm_id);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return HostAlarmAdd(su64TimeUs + us, callback, user_data);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id)
+{
+    if(alarm_id < 1 || alarm_id > HOST_MAX_ALARMS || !sAlarm[alarm_id - 1]._is_pending)
+    {
+        return false;
+    }
+    sAlarm[alarm_id - 1]._is_pending = 0;
+    return true;
+}
+
+absolute_time_t get_absolute_time(void) { return su64TimeUs; }
+absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+uint64_t time_us_64(void) { return su64TimeUs; }
+uint32_t time_us_32(void) { return (uint32_t)su64TimeUs; }
+void sleep_ms(uint32_t ms) { HostSetTimeUs(su64TimeUs + 1000ULL * ms); }
+void sleep_us(uint64_t us) { HostSetTimeUs(su64TimeUs + us); }
+
+/* IRQ and sync */
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    if(DMA_IRQ_1 == num)
+    {
+        gHostDmaIrq1 = handler;
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    if(enabled)
+    {
+        gHostIrqEnabled |= 1U << num;
+    }
+    else
+    {
+        gHostIrqEnabled &= ~(1U << num);
+    }
+}
+
+uint32_t save_and_disable_interrupts(void) { return 0; }
+void restore_interrupts(uint32_t status) {}
+void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+void __wfe(void) {}
+void __wfi(void) {}
+
+/* Flash, watchdog and USB */
+void flash_range_erase(uint32_t flash_offs, size_t count) {}
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {}
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {}
+bool tud_cdc_connected(void) { return false; }
+
+/* The loops which wait for hardware call it, an abort of DMA completes. */
+void tight_loop_contents(void)
+{
+    sDma.abort = 0;
+    if(gHostOnIdle)
+    {
+        gHostOnIdle();
+    }
+}
+
+void hw_set_bits(volatile uint32_t *addr, uint32_t mask) { *addr |= mask; }
+void hw_clear_bits(volatile uint32_t *addr, uint32_t mask) { *addr &= ~mask; }
+uint get_core_num(void) { return 1; }
+
+/* DMA */
+int dma_claim_unused_channel(bool required)
+{
+    for(int i = 0; i < 16; ++i)
+    {
+        if(!sDmaChan[i]._is_claimed)
+        {
+            sDmaChan[i]._is_claimed = 1;
+            return i;
+        }
+    }
+    assert_(!required);
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    memset(&sDmaChan[channel], 0, sizeof(HostDmaChannel));
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    /* As the SDK: 32-bit, read increment, unpaced, chained to itself. */
+    dma_channel_config c = { DMA_CH0_CTRL_TRIG_EN_BITS | DMA_CH0_CTRL_TRIG_INCR_READ_BITS
+                             | (DMA_SIZE_32 << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB)
+                             | (channel << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB)
+                             | (0x3FU << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB) };
+    return c;
+}
+
+/* Sets a field of CTRL. */
+static void HostDmaCtrlSet(dma_channel_config *c, uint32_t mask, uint32_t value)
+{
+    c->ctrl = (c->ctrl & ~mask) | (value & mask);
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    HostDmaCtrlSet(c, DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS, (uint32_t)size << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    HostDmaCtrlSet(c, DMA_CH0_CTRL_TRIG_INCR_READ_BITS, incr ? ~0U : 0);
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    HostDmaCtrlSet(c, DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS, incr ? ~0U : 0);
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    HostDmaCtrlSet(c, DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS, dreq << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to)
+{
+    HostDmaCtrlSet(c, DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS, chain_to << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits)
+{
+    assert_(size_bits < 16);
+    HostDmaCtrlSet(c, DMA_CH0_CTRL_TRIG_RING_SIZE_BITS | DMA_CH0_CTRL_TRIG_RING_SEL_BITS,
+                   (size_bits << DMA_CH0_CTRL_TRIG_RING_SIZE_LSB) | (write ? DMA_CH0_CTRL_TRIG_RING_SEL_BITS : 0));
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger)
+{
+    sDmaChan[channel]._pread = read_addr;
+    sDmaChan[channel]._pwrite = write_addr;
+    sDmaChan[channel]._u32_count = transfer_count;
+    sDmaChan[channel]._u32_ctrl = config->ctrl;
+    sDmaChan[channel]._is_started |= trigger;
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger)
+{
+    sDmaChan[channel]._pread = read_addr;
+    sDmaChan[channel]._is_started |= trigger;
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+    sDmaChan[channel]._u32_count = trans_count;
+    sDmaChan[channel]._is_started |= trigger;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    sDma.inte1 = enabled ? sDma.inte1 | (1U << channel) : sDma.inte1 & ~(1U << channel);
+}
+
+void dma_channel_start(uint channel) { sDmaChan[channel]._is_started = 1; }
+void dma_channel_abort(uint channel) { sDmaChan[channel]._is_started = 0; }
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr,
+                                          uint32_t transfer_count)
+{
+    dma_channel_set_trans_count(channel, transfer_count, false);
+    dma_channel_set_read_addr(channel, read_addr, true);
+}
+
+int dma_claim_unused_timer(bool required) { return siDmaTimers++; }
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator) {}
+uint dma_get_timer_dreq(uint timer_num) { return 59 + timer_num; }
+
+/* Clocks */
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    return clk_hstx == clk_index ? gHostClkHstxHz : gHostClkSysHz;
+}
+
+/* PWM */
+uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7; }
+
+pwm_config pwm_get_default_config(void)
+{
+    pwm_config c = { 0, 1U << 4, 0xFFFF };
+    return c;
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) { c->top = wrap; }
+void pwm_init(uint slice_num, pwm_config *c, bool start) { sPwm.slice[slice_num].top = c->top; }
+void pwm_set_gpio_level(uint gpio, uint16_t level) { sPwm.slice[pwm_gpio_to_slice_num(gpio)].cc = level; }
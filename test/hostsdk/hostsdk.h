@@ -0,0 +1,301 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  hostsdk.h - Host stand-ins of pico SDK for the host tests.
+//
+//  DESCRIPTION
+//      Declares the part of pico SDK the DCO layer and its users need, so
+//      that their sources build on a PC as they are. The registers are plain
+//      memory, the words put to PIO are captured for the tests to check.
+//      It is not a simulator: nothing runs unless a test makes it.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef HOSTSDK_H_
+#define HOSTSDK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <setjmp.h>
+
+typedef unsigned int uint;
+
+#define __not_in_flash_func(f) f
+#define __not_in_flash(x)
+#define __unused __attribute__((unused))
+#define __force_inline inline __attribute__((always_inline))
+#define PICO_DEFAULT_LED_PIN 25
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#define FLASH_SECTOR_SIZE 4096
+#define XIP_BASE ((uintptr_t)0x10000000)
+#define MHZ 1000000
+#define KHZ 1000
+#define PICO_ERROR_TIMEOUT (-1)
+
+/* PIO */
+typedef struct
+{
+    volatile uint32_t ctrl, fstat, fdebug, flevel;
+    volatile uint32_t txf[4];
+    volatile uint32_t rxf[4];
+    volatile uint32_t irq;
+    struct { volatile uint32_t clkdiv, execctrl, shiftctrl, addr, instr, pinctrl; } sm[4];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+extern pio_hw_t *pio0, *pio1;
+
+typedef struct { uint32_t clkdiv, execctrl, shiftctrl, pinctrl; } pio_sm_config;
+typedef struct { const uint16_t *instructions; uint8_t length; int8_t origin; } pio_program_t;
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX, PIO_FIFO_JOIN_RX };
+enum pio_src_dest { pio_pins = 0, pio_x = 1, pio_y = 2, pio_null = 3, pio_pindirs = 4,
+                    pio_exec_mov = 4, pio_status = 5, pio_pc = 5, pio_isr = 6, pio_osr = 7 };
+#define PIO_FDEBUG_TXSTALL_LSB 24
+#define PIO_FDEBUG_TXOVER_LSB 16
+#define PIO_FSTAT_TXFULL_LSB 16
+#define PIO_FSTAT_TXEMPTY_LSB 24
+
+int pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_enable_sm_mask_in_sync(PIO pio, uint32_t mask);
+void pio_set_sm_mask_enabled(PIO pio, uint32_t mask, bool enabled);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get(PIO pio, uint sm);
+uint32_t pio_sm_get_blocking(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm);
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+uint pio_get_index(PIO pio);
+uint pio_encode_set(enum pio_src_dest dest, uint value);
+uint pio_encode_jmp(uint addr);
+uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src);
+uint pio_encode_out(enum pio_src_dest dest, uint count);
+uint pio_encode_pull(bool if_empty, bool block);
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold);
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count);
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin);
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac);
+pio_sm_config pio_get_default_sm_config(void);
+
+/* GPIO */
+enum gpio_function { GPIO_FUNC_HSTX = 0, GPIO_FUNC_UART = 2, GPIO_FUNC_PWM = 4,
+                     GPIO_FUNC_SIO = 5, GPIO_FUNC_PIO0 = 6 };
+enum gpio_drive_strength { GPIO_DRIVE_STRENGTH_2MA = 0, GPIO_DRIVE_STRENGTH_4MA,
+                           GPIO_DRIVE_STRENGTH_8MA, GPIO_DRIVE_STRENGTH_12MA };
+enum gpio_slew_rate { GPIO_SLEW_RATE_SLOW = 0, GPIO_SLEW_RATE_FAST };
+#define GPIO_OUT 1
+#define GPIO_IN 0
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
+void gpio_set_slew_rate(uint gpio, enum gpio_slew_rate slew);
+
+/* Time and alarms */
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+typedef struct alarm_pool alarm_pool_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+typedef struct
+{
+    volatile uint32_t timehw, timelw, timehr, timelr, alarm[4], armed, timerawh, timerawl,
+                      dbgpause, pause, intr, inte, intf, ints;
+} timer_hw_t;
+extern timer_hw_t *timer_hw;
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(uint max_timers);
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback,
+                                      void *user_data, bool fire_if_past);
+alarm_id_t alarm_pool_add_alarm_at(alarm_pool_t *pool, absolute_time_t time,
+                                   alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool alarm_pool_cancel_alarm(alarm_pool_t *pool, alarm_id_t alarm_id);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+absolute_time_t get_absolute_time(void);
+absolute_time_t from_us_since_boot(uint64_t us);
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+typedef struct repeating_timer { int64_t delay_us; void *user_data; } repeating_timer_t;
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+/* IRQ and sync */
+enum { TIMER_IRQ_0 = 0, PIO1_IRQ_0 = 9, DMA_IRQ_0 = 11, DMA_IRQ_1 = 12 };
+typedef void (*irq_handler_t)(void);
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+void __dmb(void);
+void __wfe(void);
+void __wfi(void);
+void tight_loop_contents(void);
+void hw_set_bits(volatile uint32_t *addr, uint32_t mask);
+void hw_clear_bits(volatile uint32_t *addr, uint32_t mask);
+uint get_core_num(void);
+
+/* Flash, watchdog and USB, no-ops of the settings. */
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+bool tud_cdc_connected(void);
+
+/* DMA */
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+typedef struct { uint32_t ctrl; } dma_channel_config;
+#define DMA_CH0_CTRL_TRIG_EN_BITS 0x00000001
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB 2
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS 0x0000000c
+#define DMA_CH0_CTRL_TRIG_INCR_READ_BITS 0x00000010
+#define DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS 0x00000020
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_LSB 6
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_BITS 0x000003c0
+#define DMA_CH0_CTRL_TRIG_RING_SEL_BITS 0x00000400
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB 11
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS 0x00007800
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB 15
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS 0x001f8000
+typedef struct
+{
+    volatile uint32_t read_addr, write_addr, transfer_count, ctrl_trig;
+    volatile uint32_t al1_ctrl, al1_read_addr, al1_write_addr, al1_transfer_count_trig;
+    volatile uint32_t al2_ctrl, al2_transfer_count, al2_read_addr, al2_write_addr_trig;
+    volatile uint32_t al3_ctrl, al3_write_addr, al3_transfer_count, al3_read_addr_trig;
+} dma_channel_hw_t;
+typedef struct
+{
+    dma_channel_hw_t ch[16];
+    volatile uint32_t intr, inte0, intf0, ints0, _pad, inte1, intf1, ints1;
+    volatile uint32_t timer[4];
+    volatile uint32_t multi_channel_trigger, sniff_ctrl, sniff_data, _pad1, fifo_levels, abort;
+} dma_hw_t;
+extern dma_hw_t *dma_hw;
+#define DREQ_HSTX 52
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to);
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint32_t transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr,
+                                          uint32_t transfer_count);
+int dma_claim_unused_timer(bool required);
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator);
+uint dma_get_timer_dreq(uint timer_num);
+
+/* Clocks */
+enum clock_index { clk_gpout0 = 0, clk_ref = 4, clk_sys = 5, clk_peri = 6, clk_hstx = 7, clk_adc = 8 };
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+/* PWM */
+typedef struct { uint32_t csr, div, top; } pwm_config;
+typedef struct { volatile uint32_t csr, div, ctr, cc, top; } pwm_slice_hw_t;
+typedef struct { pwm_slice_hw_t slice[12]; } pwm_hw_t;
+extern pwm_hw_t *pwm_hw;
+uint pwm_gpio_to_slice_num(uint gpio);
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap);
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+
+/* UART, the GPS time module is built with its header only. */
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t *uart0, *uart1;
+typedef enum { UART_PARITY_NONE, UART_PARITY_EVEN, UART_PARITY_ODD } uart_parity_t;
+
+/* The control of the host stand-ins by tests. */
+#define HOST_PIO_CAPTURE_WORDS 65536    /* Words captured per SM. */
+#define HOST_PIO_RX_FIFO_DEPTH 8        /* RX FIFO, joined. */
+#define HOST_PIO_TXF_NONE 0xFFFFFFFFU   /* TXF of pio0 once captured, no worker puts it. */
+
+extern jmp_buf gHostStop;               /* Where a capture returns to. */
+extern uint32_t gHostClkSysHz;          /* clock_get_hz(clk_sys). */
+extern uint32_t gHostClkHstxHz;         /* clock_get_hz(clk_hstx). */
+extern irq_handler_t gHostDmaIrq1;      /* The handler of DMA_IRQ_1. */
+extern uint32_t gHostIrqEnabled;        /* Bit per IRQ enabled on the core. */
+extern void (*gHostOnPut)(uint sm, uint32_t word);  /* Called per word put. */
+extern void (*gHostOnIdle)(void);       /* Called by tight_loop_contents. */
+
+void HostReset(void);
+void HostSetTimeUs(uint64_t u64us);
+int HostAlarmRunNext(void);
+int HostAlarmRunUntil(uint64_t u64us);
+void HostPioCaptureStop(int sm, size_t nwords);
+size_t HostPioCaptured(int sm, const uint32_t **ppwords);
+int HostPioRxPush(PIO pio, uint sm, uint32_t word);
+size_t HostPioSyncs(void);
+const volatile void *HostDmaReadAddr(int chan);
+volatile void *HostDmaWriteAddr(int chan);
+uint32_t HostDmaTransCount(int chan);
+uint32_t HostDmaCtrl(int chan);
+int HostDmaStarted(int chan);
+void HostFail(const char *pfile, int line, const char *pexpr);
+
+/* The check of a test, it reports the first failure and exits non-zero. */
+#define HOST_CHECK(expr) do { if(!(expr)) HostFail(__FILE__, __LINE__, #expr); } while(0)
+
+#endif
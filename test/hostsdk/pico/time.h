@@ -0,0 +1,2 @@
+/* Host stand-in of the pico SDK header, see hostsdk.h. */
+#include "hostsdk.h"
@@ -0,0 +1,179 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  piohdr.c - Makes the header of a .pio file for the host tests.
+//
+//  DESCRIPTION
+//      pioasm is a part of pico SDK, the host build does without it. This
+//      tool writes the C side of what pioasm makes of a .pio file: the
+//      program structs with the length, the offsets of public labels and
+//      the c-sdk blocks as they are. The instructions themselves are of no
+//      use on a PC, nothing executes them there.
+//      
+//      USAGE
+//          piohdr <file.pio> <file.pio.h>
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#define PIOHDR_LINE 1024
+
+static char sProgram[64];
+static int siLength;
+static int siDeclared;
+
+/// @brief Writes the declarations of the current program, once.
+/// @param pout The header.
+static void PioHdrDeclare(FILE *pout)
+{
+    if(!sProgram[0] || siDeclared)
+    {
+        return;
+    }
+    fprintf(pout, "\nstatic const pio_program_t %s_program = { NULL, %d, -1 };\n", sProgram, siLength);
+    fprintf(pout, "static inline pio_sm_config %s_program_get_default_config(uint offset)\n"
+                  "{\n    return pio_get_default_sm_config();\n}\n", sProgram);
+    siDeclared = 1;
+}
+
+/// @brief Strips a comment and the white space around a line of .pio.
+/// @param pline The line.
+/// @return Ptr to the stripped line.
+static char *PioHdrStrip(char *pline)
+{
+    char *pc = strchr(pline, ';');
+    if(pc) *pc = 0;
+    pc = strstr(pline, "//");
+    if(pc) *pc = 0;
+    while(isspace((unsigned char)*pline)) ++pline;
+    size_t n = strlen(pline);
+    while(n && isspace((unsigned char)pline[n - 1])) pline[--n] = 0;
+
+    return pline;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc != 3)
+    {
+        fprintf(stderr, "usage: piohdr <file.pio> <file.pio.h>\n");
+        return 2;
+    }
+
+    FILE *pin = fopen(argv[1], "r");
+    FILE *pout = fopen(argv[2], "w");
+    if(!pin || !pout)
+    {
+        perror("piohdr");
+        return 1;
+    }
+
+    fprintf(pout, "/* Made of %s by piohdr for the host tests. */\n#pragma once\n"
+                  "#include \"hostsdk.h\"\n", argv[1]);
+
+    char line[PIOHDR_LINE];
+    int in_block = 0, is_csdk = 0;
+    while(fgets(line, sizeof(line), pin))
+    {
+        if(in_block)
+        {
+            if(0 == strncmp(line, "%}", 2))
+            {
+                in_block = 0;
+            }
+            else if(is_csdk)
+            {
+                fputs(line, pout);
+            }
+            continue;
+        }
+        if('%' == line[0])
+        {
+            in_block = 1;
+            is_csdk = NULL != strstr(line, "c-sdk");
+            if(is_csdk)
+            {
+                PioHdrDeclare(pout);
+            }
+            continue;
+        }
+
+        char *ps = PioHdrStrip(line);
+        char label[64];
+        if(!*ps)
+        {
+            continue;
+        }
+        if(1 == sscanf(ps, ".program %63s", sProgram))
+        {
+            siLength = siDeclared = 0;
+            continue;
+        }
+        if('.' == *ps)
+        {
+            continue;
+        }
+        if(1 == sscanf(ps, "public %63[A-Za-z0-9_]:", label))
+        {
+            fprintf(pout, "#define %s_offset_%s %du\n", sProgram, label, siLength);
+            ps = strchr(ps, ':') + 1;
+        }
+        else if(1 == sscanf(ps, "%63[A-Za-z0-9_]:", label) && strchr(ps, ':'))
+        {
+            ps = strchr(ps, ':') + 1;
+        }
+        if(*PioHdrStrip(ps))
+        {
+            ++siLength;
+            if(siDeclared)
+            {
+                fprintf(stderr, "piohdr: %s: code after c-sdk block\n", sProgram);
+                return 1;
+            }
+        }
+    }
+    PioHdrDeclare(pout);
+
+    fclose(pin);
+    fclose(pout);
+
+    return 0;
+}
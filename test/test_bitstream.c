@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_bitstream.c - Host test of the bitstream engine of DCO.
+//
+//  DESCRIPTION
+//      The waveform of a tone is to loop with a whole number of RF cycles, the
+//      freq of it being that of the tone plus the error reported; each edge is
+//      to be within a bit of the ideal one, and the mark the duty of the band.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+
+#include <math.h>
+
+#define TEST_FREQ_STEP_MILLIHZ 2930     /* WSPR tone spacing, *2 as WSPR_FREQ_STEP_MILHZ. */
+
+static PioDco sDCO;
+
+/// @brief Gets a bit of the looped waveform of a tone.
+/// @param itone Index of the tone.
+/// @param k Index of the bit, any.
+/// @return The bit.
+static int TestBit(int itone, uint64_t k)
+{
+    const uint64_t u64bits = 32ULL * sDCO._u16_pattern_len[itone];
+    k %= u64bits;
+    return (sui32_pattern[itone][k >> 5] >> (k & 31)) & 1;
+}
+
+/// @brief Checks the waveform of a tone.
+/// @param itone Index of the tone.
+/// @param want_hz The freq of tone, Hz.
+/// @param duty_permille The duty, 1e-3.
+/// @param pu32cycles Ptr to the RF cycles of the loop.
+static void TestTone(int itone, double want_hz, int duty_permille, uint32_t *pu32cycles)
+{
+    const uint32_t u32q = sDCO._u16_pattern_len[itone];
+    HOST_CHECK(u32q >= 1 && u32q <= PIODCO_PATTERN_MAX_WORDS);
+    const uint64_t u64bits = 32ULL * u32q;
+    const double bit_hz = (double)sDCO._clkfreq_hz / sDCO._u16_clkdiv;
+
+    /* The rising edges of a loop, the last one might wrap. */
+    uint32_t p = 0;
+    uint64_t u64high = 0;
+    for(uint64_t k = 0; k < u64bits; ++k)
+    {
+        p += TestBit(itone, k) && !TestBit(itone, k + u64bits - 1);
+        u64high += TestBit(itone, k);
+    }
+    HOST_CHECK(p > 0);
+
+    const double frq_hz = bit_hz * p / u64bits * sDCO._u8_harmonic_n;
+
+    /* The edges are at the bit the phase of fundamental crosses. */
+    const double bits_per_cycle = (double)u64bits / p;
+    uint32_t n = 0;
+    for(uint64_t k = 0; k < u64bits; ++k)
+    {
+        if(TestBit(itone, k) && !TestBit(itone, k + u64bits - 1))
+        {
+            HOST_CHECK(fabs(k - n * bits_per_cycle) < 1.0);
+            ++n;
+        }
+    }
+    HOST_CHECK(n == p);
+
+    /* The mark is the duty, within the bit it ends at per cycle. */
+    const double mark = (double)u64high / p;
+    HOST_CHECK(fabs(mark - bits_per_cycle * duty_permille / 1000.0) < 1.0);
+
+    *pu32cycles = p;
+}
+
+/// @brief Checks the waveforms of the tones of a WSPR transmission.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq of tone 0, Hz.
+/// @param duty_permille The duty, 1e-3.
+static void TestBitstream(uint32_t u32clk_hz, uint32_t u32frq_hz, int duty_permille)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, eDCOENGINE_BITSTREAM);
+    PioDCOSetHarmonic(&sDCO, 0);
+    PioDCOSetDuty(&sDCO, duty_permille);
+    PioDCOSetFreq(&sDCO, u32frq_hz, 0);
+
+    int32_t i32worst = 0;
+    uint32_t u32cycles = 0;
+    for(int i = PIODCO_PATTERN_TONES - 1; i >= 0; --i)
+    {
+        HOST_CHECK(0 == PioDCOPatternBuild(&sDCO, i, u32frq_hz, i * TEST_FREQ_STEP_MILLIHZ));
+        TestTone(i, u32frq_hz + 0.5e-3 * i * TEST_FREQ_STEP_MILLIHZ, duty_permille, &u32cycles);
+        const int32_t i32err = abs(sDCO._i32_pattern_err_millihz[i]);
+        i32worst = i32err > i32worst ? i32err : i32worst;
+    }
+
+    /* The suspend puts SM back to dco u-program, for any engine of next run. */
+    PioDCOSetProgram(&sDCO, eDCOPROG_BITS);
+    PioDCOSuspend(&sDCO);
+    HOST_CHECK(eDCOPROG_DCO == sDCO._program);
+
+    printf("%9lu Hz at %3lu MHz N=%d duty %3d: %4u words, %6lu cycles, error %8ld mHz, worst tone %8ld mHz\n",
+           (unsigned long)u32frq_hz, (unsigned long)(u32clk_hz / MHZ), sDCO._u8_harmonic_n,
+           duty_permille, sDCO._u16_pattern_len[0], (unsigned long)u32cycles,
+           (long)sDCO._i32_pattern_err_millihz[0], (long)i32worst);
+}
+
+int main(void)
+{
+    static const uint32_t au32frq_hz[] = { 137500, 475700, 1838100, 3570100, 7040100, 10140200,
+                                           14097100, 18106100, 21096100, 24926100, 28126100,
+                                           50294500 };
+    for(size_t i = 0; i < sizeof(au32frq_hz) / sizeof(au32frq_hz[0]); ++i)
+    {
+        TestBitstream(200000000, au32frq_hz[i], 500);
+    }
+
+    TestBitstream(125000000, 7040100, 500);
+    TestBitstream(200000000, 7040100, 300);
+    TestBitstream(200000000, 3570100, 250);
+
+    return 0;
+}
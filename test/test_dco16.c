@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_dco16.c - Host test of dco16 u-program of DCO.
+//
+//  DESCRIPTION
+//      CPU engine is to run dco16 where the fundamental is up to CLK/32 and dco
+//      above. dco16 edges are to be within a cycle of the ideal ones, each half
+//      being corrected by PLL, so the phase error is to be lower than that of
+//      dco at the same freq.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "hostdco.h"
+
+#define TEST_WORDS 8192
+
+static PioDco sDCO;
+static uint64_t su64Edges[4 * TEST_WORDS];
+static uint32_t su32SwitchAt;       /* The word the freq is switched at, 0 none. */
+static uint32_t su32SwitchHz;
+
+/// @brief Sets the freq to switch to from the worker, as if core0 did.
+/// @param sm The SM the word is put to.
+/// @param word The word.
+static void TestOnPut(uint sm, uint32_t word)
+{
+    if(su32SwitchAt && HostPioCaptured(sm, NULL) == su32SwitchAt)
+    {
+        PioDCOSetFreq(&sDCO, su32SwitchHz, 0);
+    }
+}
+
+/// @brief Runs CPU worker V.2 of a DCO on an engine at a freq.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param engine The engine the freq is calculated for.
+/// @param u32frq_hz The freq, Hz.
+/// @return Ptr to the words.
+static const uint32_t *TestRun(uint32_t u32clk_hz, enum PioDcoEngine engine, uint32_t u32frq_hz)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, engine);
+    PioDCOSetFreq(&sDCO, u32frq_hz, 0);
+    gHostOnPut = TestOnPut;
+
+    const uint32_t *pu32words;
+    HostPioCaptureStop(sDCO._ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorker2(&sDCO);
+    }
+    HOST_CHECK(TEST_WORDS == HostPioCaptured(sDCO._ism, &pu32words));
+
+    return pu32words;
+}
+
+/// @brief Checks dco16 at a freq of its range against dco.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+static void TestDco16(uint32_t u32clk_hz, uint32_t u32frq_hz)
+{
+    const uint32_t *pu32words = TestRun(u32clk_hz, eDCOENGINE_CPU, u32frq_hz);
+    HOST_CHECK(eDCOPROG_DCO16 == sDCO._program);
+    const double cycles_per_pi = (double)sDCO._frq_cycles_per_pi / (1 << 24);
+
+    /* Each edge is within a cycle of the ideal one. */
+    const size_t n16 = HostDco16Edges(pu32words, TEST_WORDS, su64Edges);
+    for(size_t k = 0; k < n16; ++k)
+    {
+        HOST_CHECK(fabs((double)su64Edges[k] - (k + 1) * cycles_per_pi) < 1.0);
+    }
+    const HostPhaseError err16 = HostEdgeError(su64Edges, n16, 1, cycles_per_pi);
+
+    pu32words = TestRun(u32clk_hz, eDCOENGINE_DMA, u32frq_hz);
+    HOST_CHECK(eDCOPROG_DCO == sDCO._program);
+    const size_t n = HostDcoEdges(pu32words, TEST_WORDS, su64Edges);
+    const HostPhaseError err = HostEdgeError(su64Edges, n, 1, cycles_per_pi);
+
+    HOST_CHECK(err16._rms_deg < err._rms_deg);
+    HOST_CHECK(err16._peak_deg < err._peak_deg);
+    printf("%9lu Hz at %3lu MHz clkdiv %u: dco %5.2f / %5.2f deg, dco16 %5.2f / %5.2f deg rms / peak\n",
+           (unsigned long)u32frq_hz, (unsigned long)(u32clk_hz / MHZ), sDCO._u16_clkdiv,
+           err._rms_deg, err._peak_deg, err16._rms_deg, err16._peak_deg);
+}
+
+/// @brief Checks the u-program is switched with the freq while running.
+static void TestSwitch(void)
+{
+    su32SwitchAt = TEST_WORDS / 2;
+    su32SwitchHz = 7040100;
+    TestRun(200000000, eDCOENGINE_CPU, 3570100);
+    su32SwitchAt = 0;
+    HOST_CHECK(eDCOPROG_DCO == sDCO._program);
+    printf("dco16 -> dco on switch to %lu Hz\n", (unsigned long)su32SwitchHz);
+}
+
+int main(void)
+{
+    TestDco16(200000000, 137500);
+    TestDco16(200000000, 475700);
+    TestDco16(200000000, 1838100);
+    TestDco16(200000000, 3570100);
+    TestDco16(125000000, 3570100);
+
+    /* Above CLK/32 it is dco. */
+    TestRun(200000000, eDCOENGINE_CPU, 7040100);
+    HOST_CHECK(eDCOPROG_DCO == sDCO._program);
+
+    TestSwitch();
+
+    return 0;
+}
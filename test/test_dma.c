@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_dma.c - Host test of DMA engine of DCO.
+//
+//  DESCRIPTION
+//      The words the DMA engine refills its ping-pong buffers with are to be
+//      the very words the CPU worker puts to SM, buffer after buffer, as the
+//      DMA channels chain to each other. The PLL keeps the sum of words to
+//      the cycles of the freq within one cycle.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+
+#define TEST_WORDS (16 * PIODCO_DMA_BUF_WORDS)
+
+/// @brief Captures the words of CPU worker V.2 at a freq.
+/// @param pdco Ptr to DCO context.
+/// @param ppwords Ptr to the words captured.
+static void TestCaptureWorker2(PioDco *pdco, const uint32_t **ppwords)
+{
+    HostPioCaptureStop(pdco->_ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorker2(pdco);
+    }
+    HOST_CHECK(TEST_WORDS == HostPioCaptured(pdco->_ism, ppwords));
+}
+
+/// @brief Runs DMA engine of a DCO: the channels send their buffers in turn,
+/// @brief the completion IRQ refills the one which has been sent.
+/// @param pdco Ptr to DCO context.
+/// @param pu32words Ptr to the words sent.
+static void TestRunDMA(PioDco *pdco, uint32_t *pu32words)
+{
+    for(int n = 0, i = 0; n < TEST_WORDS; n += PIODCO_DMA_BUF_WORDS, i ^= 1)
+    {
+        HOST_CHECK(HostDmaReadAddr(pdco->_dma_chan[i]) == pdco->_ui32_dmabuf[i]);
+        memcpy(pu32words + n, pdco->_ui32_dmabuf[i], sizeof(pdco->_ui32_dmabuf[i]));
+
+        /* INTS1 is write-1-to-clear, memory keeps what the handler writes. */
+        dma_hw->ints1 = 1U << pdco->_dma_chan[i];
+        gHostDmaIrq1();
+        dma_hw->ints1 = 0;
+    }
+}
+
+/// @brief Checks DMA engine against CPU worker at a freq of dco u-program,
+/// @brief the CPU worker runs dco16 below CLK/PIODCO_DCO16_CLK_RATIO.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+/// @param i32frq_millihz The freq shift, mHz.
+static void TestDMAvsWorker2(uint32_t u32clk_hz, uint32_t u32frq_hz, int32_t i32frq_millihz)
+{
+    static PioDco dco;
+    static uint32_t u32dma[TEST_WORDS];
+    const uint32_t *pu32cpu;
+
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    HOST_CHECK(0 == PioDCOInit(&dco, 6));
+    PioDCOSetFreq(&dco, u32frq_hz, i32frq_millihz);
+    HOST_CHECK(eDCOPROG_DCO == dco._freq[dco._u32_freq_seq & 1]._u8_program);
+    TestCaptureWorker2(&dco, &pu32cpu);
+
+    HostReset();
+    memset(spDMAdco, 0, sizeof(spDMAdco));
+    HOST_CHECK(0 == PioDCOInit(&dco, 6));
+    PioDCOSetEngine(&dco, eDCOENGINE_DMA);
+    PioDCOSetFreq(&dco, u32frq_hz, i32frq_millihz);
+    HOST_CHECK(0 == PioDCODMAInit(&dco));
+    HOST_CHECK(gHostDmaIrq1);
+    HOST_CHECK(HostDmaStarted(dco._dma_chan[0]));
+    TestRunDMA(&dco, u32dma);
+
+    HOST_CHECK(0 == memcmp(pu32cpu, u32dma, sizeof(u32dma)));
+
+    /* A word lasts (word + delay) cycles per PI of the freq. */
+    int64_t i64cycles = 0;
+    for(int i = 0; i < TEST_WORDS; ++i)
+    {
+        i64cycles += ((int64_t)u32dma[i] + PIOASM_DELAY_CYCLES) << 24;
+    }
+    const int64_t i64error = i64cycles - (int64_t)TEST_WORDS * dco._frq_cycles_per_pi;
+    HOST_CHECK(i64error > -(1LL << 24) && i64error < (1LL << 24));
+
+    printf("%9lu Hz at %3lu MHz: %d words match, PLL error %.3f cycles\n", (unsigned long)u32frq_hz,
+           (unsigned long)(u32clk_hz / MHZ), TEST_WORDS, (double)i64error / (1 << 24));
+}
+
+/// @brief Checks that a DCO on DMA engine keeps being refilled when the one
+/// @brief before it is suspended, which leaves a hole in the slots of IRQ.
+static void TestDMAHole(void)
+{
+    static PioDco dco[3];
+
+    HostReset();
+    memset(spDMAdco, 0, sizeof(spDMAdco));
+    for(int i = 0; i < 3; ++i)
+    {
+        HOST_CHECK(0 == PioDCOInit(&dco[i], 6 + i));
+        PioDCOSetEngine(&dco[i], eDCOENGINE_DMA);
+        PioDCOSetFreq(&dco[i], 7040100 + 1000 * i, 0);
+        HOST_CHECK(0 == PioDCODMAInit(&dco[i]));
+    }
+    PioDCOSuspend(&dco[0]);
+    HOST_CHECK(NULL == spDMAdco[0] && &dco[1] == spDMAdco[1]);
+
+    for(int i = 1; i < 3; ++i)
+    {
+        const uint32_t u32fed = dco[i]._u32_fed_words;
+        dma_hw->ints1 = 1U << dco[i]._dma_chan[0];
+        gHostDmaIrq1();
+        dma_hw->ints1 = 0;
+        HOST_CHECK(u32fed + PIODCO_DMA_BUF_WORDS == dco[i]._u32_fed_words);
+    }
+
+    /* The hole is taken again, the handler is the one installed. The IRQ is
+       enabled again, as the reset of core1 has disabled it. */
+    const irq_handler_t phandler = gHostDmaIrq1;
+    gHostDmaIrq1 = NULL;
+    HOST_CHECK(gHostIrqEnabled & (1U << DMA_IRQ_1));
+    irq_set_enabled(DMA_IRQ_1, false);
+    HOST_CHECK(0 == PioDCOInit(&dco[0], 6));
+    PioDCOSetEngine(&dco[0], eDCOENGINE_DMA);
+    PioDCOSetFreq(&dco[0], 7040100, 0);
+    HOST_CHECK(0 == PioDCODMAInit(&dco[0]));
+    HOST_CHECK(&dco[0] == spDMAdco[0] && NULL == gHostDmaIrq1);
+    HOST_CHECK(gHostIrqEnabled & (1U << DMA_IRQ_1));
+    gHostDmaIrq1 = phandler;
+
+    printf("DMA IRQ refills the DCOs after a suspended one\n");
+}
+
+int main(void)
+{
+    TestDMAvsWorker2(125000000, 10140200, 0);
+    TestDMAvsWorker2(125000000, 7040100, 0);
+    TestDMAvsWorker2(200000000, 14097100, 1465);
+    TestDMAvsWorker2(270000000, 28126100, -2930);
+    TestDMAHole();
+
+    return 0;
+}
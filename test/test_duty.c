@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_duty.c - Host test of duty cycle of dco16 u-program.
+//
+//  DESCRIPTION
+//      The mark of each RF period is to be the duty of it, within the cycles
+//      of dither, the sum of marks the duty of the whole, and the period edges
+//      are to stay within a cycle of the ideal ones as at 50%.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "hostdco.h"
+
+#define TEST_WORDS 8192
+
+static PioDco sDCO;
+static uint64_t su64Edges[2 * TEST_WORDS];
+
+/// @brief Runs CPU worker V.2 at a freq and a duty.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+/// @param duty_permille The duty, 1e-3.
+/// @return Ptr to the words.
+static const uint32_t *TestRun(uint32_t u32clk_hz, uint32_t u32frq_hz, int duty_permille)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetDuty(&sDCO, duty_permille);
+    PioDCOSetFreq(&sDCO, u32frq_hz, 0);
+
+    const uint32_t *pu32words;
+    HostPioCaptureStop(sDCO._ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorker2(&sDCO);
+    }
+    HOST_CHECK(TEST_WORDS == HostPioCaptured(sDCO._ism, &pu32words));
+
+    return pu32words;
+}
+
+/// @brief Checks the duty of dco16 output.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+/// @param duty_permille The duty, 1e-3.
+static void TestDuty(uint32_t u32clk_hz, uint32_t u32frq_hz, int duty_permille)
+{
+    const uint32_t *pu32words = TestRun(u32clk_hz, u32frq_hz, duty_permille);
+    HOST_CHECK(eDCOPROG_DCO16 == sDCO._program);
+
+    const double cycles_per_pi = (double)sDCO._frq_cycles_per_pi / (1 << 24);
+    const double duty = 1e-3 * duty_permille;
+    const size_t n = HostDco16Edges(pu32words, TEST_WORDS, su64Edges);
+
+    /* The low half goes first, the period ends with the high one. */
+    uint64_t u64mark = 0;
+    double max_mark_error = 0.0;
+    for(size_t k = 1; k < n; k += 2)
+    {
+        HOST_CHECK(fabs((double)su64Edges[k] - (k + 1) * cycles_per_pi) < 1.0);
+
+        const uint64_t u64m = su64Edges[k] - su64Edges[k - 1];
+        const double mark_error = fabs((double)u64m - 2.0 * duty * cycles_per_pi);
+        HOST_CHECK(mark_error < 2.0);
+        max_mark_error = mark_error > max_mark_error ? mark_error : max_mark_error;
+        u64mark += u64m;
+    }
+    const double measured = (double)u64mark / su64Edges[n - 1];
+    HOST_CHECK(fabs(measured - duty) < 1e-4);
+
+    printf("%9lu Hz at %3lu MHz duty %3d: measured %.5f, mark within %.2f cycles\n",
+           (unsigned long)u32frq_hz, (unsigned long)(u32clk_hz / MHZ), duty_permille,
+           measured, max_mark_error);
+}
+
+int main(void)
+{
+    static const int duty[] = { PIODCO_DUTY_MIN_PERMILLE, 300, 450, 499, 500, 700, PIODCO_DUTY_MAX_PERMILLE };
+    for(size_t i = 0; i < sizeof(duty) / sizeof(duty[0]); ++i)
+    {
+        TestDuty(200000000, 475700, duty[i]);
+        TestDuty(200000000, 3570100, duty[i]);
+    }
+    TestDuty(125000000, 3570100, PIODCO_DUTY_MIN_PERMILLE);
+
+    /* dco is 50% whatever the duty is. */
+    TestRun(200000000, 7040100, 300);
+    HOST_CHECK(eDCOPROG_DCO == sDCO._program);
+
+    return 0;
+}
@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_envelope.c - Host test of CW keying and its envelope.
+//
+//  DESCRIPTION
+//      Key up is to stop the worker feeding SM on a word boundary, so SM stalls
+//      on a whole cycle, and the PLL goes on from where it was at key down. The
+//      envelope is to ramp up and down by DMA along the raised cosine tables,
+//      the carrier being keyed up at the end of the fall ramp. The keying
+//      spectrum of the ramps is measured against hard keying.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+
+#include <complex.h>
+
+#define TEST_WORDS 4096
+#define TEST_KEY_UP_WORD 1000       /* The word key up is called at. */
+#define TEST_IDLE_LOOPS 100         /* The polls key down is called after. */
+
+#define TEST_FFT_LOG2 17
+#define TEST_FFT_LEN (1 << TEST_FFT_LOG2)
+#define TEST_RATE_HZ 128000         /* 10 samples per envelope step. */
+#define TEST_DIT_SAMPLES 7680       /* 60 ms, a dit of 20 WPM. */
+
+static PioDco sDCO;
+static uint32_t su32KeyDownWords;   /* The words put when keyed down. */
+static int siIdle;
+
+/// @brief Keys up at a word, as if core0 did.
+/// @param sm The SM the word is put to.
+/// @param word The word.
+static void TestOnPut(uint sm, uint32_t word)
+{
+    if(TEST_KEY_UP_WORD == HostPioCaptured(sm, NULL))
+    {
+        PioDCOKeyUp(&sDCO);
+    }
+}
+
+/// @brief Keys down after the worker has waited a while.
+static void TestOnIdle(void)
+{
+    if(++siIdle == TEST_IDLE_LOOPS)
+    {
+        su32KeyDownWords = HostPioCaptured(sDCO._ism, NULL);
+        PioDCOKeyDown(&sDCO);
+    }
+}
+
+/// @brief Sets up a DCO on an engine.
+/// @param engine The engine.
+static void TestSetup(enum PioDcoEngine engine)
+{
+    HostReset();
+    gHostClkSysHz = 125000000;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, engine);
+    PioDCOSetFreq(&sDCO, 7040100, 0);
+    PioDCOStart(&sDCO);
+}
+
+/// @brief Keys CPU worker up and down while it runs.
+static void TestKeying(void)
+{
+    TestSetup(eDCOENGINE_CPU);
+    gHostOnPut = TestOnPut;
+    gHostOnIdle = TestOnIdle;
+    siIdle = 0;
+
+    const uint32_t *pu32words;
+    HostPioCaptureStop(sDCO._ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorker2(&sDCO);
+    }
+    HOST_CHECK(TEST_WORDS == HostPioCaptured(sDCO._ism, &pu32words));
+
+    /* No word is put while keyed up. */
+    HOST_CHECK(siIdle >= TEST_IDLE_LOOPS);
+    HOST_CHECK(TEST_KEY_UP_WORD == su32KeyDownWords);
+    HOST_CHECK(sDCO._is_enabled);
+
+    /* The PLL goes on as if there were no gap. */
+    int64_t i64cycles = 0;
+    for(int i = 0; i < TEST_WORDS; ++i)
+    {
+        i64cycles += ((int64_t)pu32words[i] + PIOASM_DELAY_CYCLES) << 24;
+    }
+    const int64_t i64error = i64cycles - (int64_t)TEST_WORDS * sDCO._frq_cycles_per_pi;
+    HOST_CHECK(i64error > -(1LL << 24) && i64error < (1LL << 24));
+
+    printf("Keyed up at word %d for %d polls, PLL error %.3f cycles\n", TEST_KEY_UP_WORD, siIdle,
+           (double)i64error / (1 << 24));
+}
+
+/// @brief Checks the engines which can't stall are stopped by key up.
+static void TestKeyingDMA(void)
+{
+    TestSetup(eDCOENGINE_DMA);
+    PioDCOKeyUp(&sDCO);
+    HOST_CHECK(!sDCO._is_enabled);
+    PioDCOKeyDown(&sDCO);
+    HOST_CHECK(sDCO._is_enabled);
+}
+
+/// @brief Checks the ramps of envelope and the key up at the end of fall.
+static void TestEnvelope(void)
+{
+    TestSetup(eDCOENGINE_CPU);
+    HOST_CHECK(0 == PioDCOEnvelopeInit(&sDCO, 10));
+    const uint slice = pwm_gpio_to_slice_num(10);
+    HOST_CHECK(PIODCO_ENV_PWM_WRAP == pwm_hw->slice[slice].top);
+    HOST_CHECK(HostDmaWriteAddr(sDCO._env_dma_chan) == &pwm_hw->slice[slice].cc);
+
+    /* Raised cosine, the same level to both channels of slice. */
+    for(int i = 0; i < PIODCO_ENV_STEPS; ++i)
+    {
+        const double s = sin(M_PI / 2 * (i + 1) / PIODCO_ENV_STEPS);
+        const uint32_t u32level = su32_env_rise[i] & 0xFFFFU;
+        HOST_CHECK(u32level == su32_env_rise[i] >> 16);
+        HOST_CHECK(fabs(u32level - s * s * PIODCO_ENV_PWM_WRAP) <= 1.0);
+        HOST_CHECK(!i || u32level >= (su32_env_rise[i - 1] & 0xFFFFU));
+        HOST_CHECK(su32_env_fall[i] == (i < PIODCO_ENV_STEPS - 1 ? su32_env_rise[PIODCO_ENV_STEPS - 2 - i] : 0));
+    }
+    HOST_CHECK(PIODCO_ENV_PWM_WRAP == (su32_env_rise[PIODCO_ENV_STEPS - 1] & 0xFFFFU));
+
+    PioDCOKeyDown(&sDCO);
+    HOST_CHECK(HostDmaReadAddr(sDCO._env_dma_chan) == su32_env_rise);
+    HOST_CHECK(PIODCO_ENV_STEPS == HostDmaTransCount(sDCO._env_dma_chan));
+
+    /* The carrier lasts the fall ramp. */
+    HostSetTimeUs(1000000);
+    PioDCOKeyUp(&sDCO);
+    HOST_CHECK(HostDmaReadAddr(sDCO._env_dma_chan) == su32_env_fall);
+    HOST_CHECK(!sDCO._u8_key_up && !sDCO._freq[sDCO._u32_freq_seq & 1]._u8_key_up);
+    HOST_CHECK(HostAlarmRunNext());
+    HOST_CHECK(1000000 + PIODCO_ENV_RAMP_US == time_us_64());
+    HOST_CHECK(sDCO._u8_key_up && sDCO._freq[sDCO._u32_freq_seq & 1]._u8_key_up);
+
+    /* Key down during the fall ramp cancels the key up. */
+    PioDCOKeyDown(&sDCO);
+    PioDCOKeyUp(&sDCO);
+    PioDCOKeyDown(&sDCO);
+    HOST_CHECK(!HostAlarmRunNext());
+    HOST_CHECK(!sDCO._u8_key_up && !sDCO._freq[sDCO._u32_freq_seq & 1]._u8_key_up);
+    HOST_CHECK(HostDmaReadAddr(sDCO._env_dma_chan) == su32_env_rise);
+}
+
+/// @brief In-place radix-2 FFT.
+/// @param px Ptr to TEST_FFT_LEN samples.
+static void TestFFT(double complex *px)
+{
+    for(uint32_t i = 1, j = 0; i < TEST_FFT_LEN; ++i)
+    {
+        uint32_t bit = TEST_FFT_LEN >> 1;
+        for(; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j)
+        {
+            const double complex t = px[i];
+            px[i] = px[j];
+            px[j] = t;
+        }
+    }
+    for(uint32_t len = 2; len <= TEST_FFT_LEN; len <<= 1)
+    {
+        const double complex w = cexp(-2.0 * I * M_PI / len);
+        for(uint32_t i = 0; i < TEST_FFT_LEN; i += len)
+        {
+            double complex wk = 1.0;
+            for(uint32_t k = 0; k < len / 2; ++k, wk *= w)
+            {
+                const double complex u = px[i + k], v = px[i + k + len / 2] * wk;
+                px[i + k] = u + v;
+                px[i + k + len / 2] = u - v;
+            }
+        }
+    }
+}
+
+/// @brief Measures the keying spectrum of dits: the two-sided width of 99%
+/// @brief of power, and the one out of which it is below a level.
+/// @param envelope Whether the ramps of envelope are used, or hard keying.
+/// @param pw99 Ptr to the width of 99% power, Hz.
+/// @param pw40 Ptr to the width of -40 dBc, Hz.
+static void TestKeyingSpectrum(int envelope, double *pw99, double *pw40)
+{
+    static double complex x[TEST_FFT_LEN];
+    const int step = TEST_RATE_HZ / (PIODCO_ENV_STEPS * 1000000 / PIODCO_ENV_RAMP_US);
+
+    /* A ramp starts at the key edge, the carrier lasts the fall one. */
+    for(int i = 0; i < TEST_FFT_LEN; ++i)
+    {
+        const int t = i % (2 * TEST_DIT_SAMPLES);
+        double a;
+        if(!envelope)
+        {
+            a = t < TEST_DIT_SAMPLES;
+        }
+        else if(t < TEST_DIT_SAMPLES)
+        {
+            a = t < PIODCO_ENV_STEPS * step ? (su32_env_rise[t / step] & 0xFFFFU) : PIODCO_ENV_PWM_WRAP;
+            a /= PIODCO_ENV_PWM_WRAP;
+        }
+        else
+        {
+            const int tf = t - TEST_DIT_SAMPLES;
+            a = tf < PIODCO_ENV_STEPS * step ? (double)(su32_env_fall[tf / step] & 0xFFFFU) / PIODCO_ENV_PWM_WRAP : 0.0;
+        }
+        /* Hann window, the ends of record don't add a key edge. */
+        x[i] = a * (0.5 - 0.5 * cos(2.0 * M_PI * i / TEST_FFT_LEN));
+    }
+    TestFFT(x);
+
+    double total = 0.0;
+    for(int k = 0; k < TEST_FFT_LEN; ++k)
+    {
+        total += creal(x[k] * conj(x[k]));
+    }
+    const double carrier = creal(x[0] * conj(x[0]));
+
+    /* Both sides at once, from the carrier out. */
+    double inside = carrier;
+    int k99 = 0, k40 = 0;
+    for(int k = 1; k < TEST_FFT_LEN / 2; ++k)
+    {
+        const double p = creal(x[k] * conj(x[k])) + creal(x[TEST_FFT_LEN - k] * conj(x[TEST_FFT_LEN - k]));
+        if(inside < 0.99 * total)
+        {
+            k99 = k;
+        }
+        inside += p;
+        if(p > 2.0 * 1e-4 * carrier)
+        {
+            k40 = k;
+        }
+    }
+    *pw99 = 2.0 * k99 * TEST_RATE_HZ / TEST_FFT_LEN;
+    *pw40 = 2.0 * k40 * TEST_RATE_HZ / TEST_FFT_LEN;
+}
+
+int main(void)
+{
+    TestKeying();
+    TestKeyingDMA();
+    TestEnvelope();
+
+    double hard99, hard40, env99, env40;
+    TestKeyingSpectrum(NO, &hard99, &hard40);
+    TestKeyingSpectrum(YES, &env99, &env40);
+    printf("Dits of 20 WPM, widths of 99%% power / -40 dBc: hard %.0f / %.0f Hz, envelope %.0f / %.0f Hz\n",
+           hard99, hard40, env99, env40);
+    HOST_CHECK(env99 < hard99);
+    HOST_CHECK(env40 < hard40);
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_fcount.c - Host test of the frequency counter.
+//
+//  DESCRIPTION
+//      The RX FIFO of counter SM is fed by a model of fcount u-program: X counts
+//      the RF edges down and is pushed at the first edge after each PPS, which
+//      is seen up to 2 SM cycles late. The slope of the gate is to be within the
+//      edge quantization of the freq, and better than the plain difference of
+//      the first and the last count.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../FreqCounter/FreqCounter.c"
+
+#include <math.h>
+
+#define TEST_COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+#define TEST_CLK_HZ 200000000.0
+#define TEST_IDLE_US 1000           /* Time passed per poll of RX FIFO. */
+#define TEST_PPS_PHASE_S 0.3        /* PPS edges are at it + whole s. */
+#define TEST_PPM 2.3                /* The error of RF freq. */
+#define TEST_TRIALS 100
+
+static FreqCounterContext sFC;
+static double sfRfHz;               /* True freq of RF. */
+static double sfRfPhase;            /* Its phase at 0, cycles. */
+static uint64_t su64NextPpsUs;
+static uint32_t su32X0;             /* X at 0. */
+static int siPpsLeft;              /* PPS edges yet to come, -1 all. */
+static int64_t si64Counts[FREQCOUNTER_MAX_GATE_S + 2];
+static int siCounts;
+static uint64_t su64Rand = 88172645463325252ULL;
+
+/// @brief A uniform random number.
+/// @return It, [0, 1).
+static double TestRand(void)
+{
+    su64Rand ^= su64Rand << 13;
+    su64Rand ^= su64Rand >> 7;
+    su64Rand ^= su64Rand << 17;
+    return (su64Rand >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/// @brief Tells whether the counter SM runs.
+/// @return Non-zero if it does.
+static int TestIsEnabled(void)
+{
+    return sFC._pio->ctrl & (1U << sFC._ism);
+}
+
+/// @brief Lets time go on and latches X of fcount SM at each PPS.
+static void TestOnIdle(void)
+{
+    HostSetTimeUs(time_us_64() + TEST_IDLE_US);
+    if(!siPpsLeft || time_us_64() < su64NextPpsUs)
+    {
+        return;
+    }
+
+    const double t = su64NextPpsUs * 1e-6 + TestRand() * 2.0 / TEST_CLK_HZ;
+    const int64_t i64edges = (int64_t)floor(t * sfRfHz + sfRfPhase) + 1;
+    su64NextPpsUs += 1000000;
+    siPpsLeft -= siPpsLeft > 0;
+    if(TestIsEnabled())
+    {
+        HostPioRxPush(sFC._pio, sFC._ism, su32X0 - (uint32_t)i64edges);
+        if(siCounts < (int)TEST_COUNT_OF(si64Counts))
+        {
+            si64Counts[siCounts++] = i64edges;
+        }
+    }
+}
+
+/// @brief Sets up the counter and a new RF and PPS.
+/// @param fhz The nominal freq of RF, Hz.
+static void TestSetup(double fhz)
+{
+    HostReset();
+    gHostOnIdle = TestOnIdle;
+    HOST_CHECK(0 == FreqCounterInit(&sFC, 6, 17));
+    HOST_CHECK(pio1 == sFC._pio);
+
+    sfRfHz = fhz * (1.0 + TEST_PPM * 1e-6);
+    sfRfPhase = TestRand();
+    su32X0 = (uint32_t)(TestRand() * 4294967296.0);
+    HostSetTimeUs((uint64_t)(TestRand() * 1e6));
+    su64NextPpsUs = (uint64_t)(TEST_PPS_PHASE_S * 1e6);
+    while(su64NextPpsUs <= time_us_64())
+    {
+        su64NextPpsUs += 1000000;
+    }
+    siPpsLeft = -1;
+    siCounts = 0;
+}
+
+/// @brief Measures a freq over a gate a number of times.
+/// @param fhz The nominal freq of RF, Hz.
+/// @param gate_s The gate, s.
+/// @param pfit_rms Ptr to rms error of the slope, mHz.
+/// @param pplain_rms Ptr to rms error of the plain difference, mHz.
+/// @param pworst Ptr to the worst error of the slope, mHz.
+static void TestGate(double fhz, int gate_s, double *pfit_rms, double *pplain_rms, double *pworst)
+{
+    double fit = 0.0, plain = 0.0;
+    *pworst = 0.0;
+    for(int i = 0; i < TEST_TRIALS; ++i)
+    {
+        TestSetup(fhz);
+        int64_t i64millihz;
+        HOST_CHECK(0 == FreqCounterMeasure(&sFC, gate_s, &i64millihz));
+        HOST_CHECK(!TestIsEnabled());
+
+        /* The first count is dropped. */
+        HOST_CHECK(gate_s + 2 == siCounts);
+        const double e = (double)i64millihz - sfRfHz * 1000.0;
+        const double ep = (double)(si64Counts[gate_s + 1] - si64Counts[1]) * 1000.0 / gate_s
+                        - sfRfHz * 1000.0;
+        fit += e * e;
+        plain += ep * ep;
+        *pworst = fabs(e) > *pworst ? fabs(e) : *pworst;
+        FreqCounterDeinit(&sFC);
+    }
+    *pfit_rms = sqrt(fit / TEST_TRIALS);
+    *pplain_rms = sqrt(plain / TEST_TRIALS);
+
+    printf("%10.1f Hz gate %2d s: rms %8.2f mHz (plain %8.2f), worst %8.2f mHz\n", fhz, gate_s,
+           *pfit_rms, *pplain_rms, *pworst);
+}
+
+/// @brief Checks the errors of gates.
+static void TestMeasure(void)
+{
+    const double af[] = { 1838100.0, 7040100.0, 14097100.0, 28126100.0, 49000000.0 };
+    for(size_t i = 0; i < TEST_COUNT_OF(af); ++i)
+    {
+        double fit, plain, worst;
+
+        /* A single count is within an edge. */
+        TestGate(af[i], 1, &fit, &plain, &worst);
+        HOST_CHECK(worst < 1000.0);
+
+        TestGate(af[i], 10, &fit, &plain, &worst);
+        HOST_CHECK(fit < 40.0 && fit < plain);
+
+        TestGate(af[i], 60, &fit, &plain, &worst);
+        HOST_CHECK(fit < 3.0 && fit < plain);
+    }
+}
+
+/// @brief Checks the errors of no PPS and of a gate out of range.
+static void TestErrors(void)
+{
+    int64_t i64millihz = 0;
+
+    TestSetup(7040100.0);
+    HOST_CHECK(-2 == FreqCounterMeasure(&sFC, 0, &i64millihz));
+    HOST_CHECK(-2 == FreqCounterMeasure(&sFC, FREQCOUNTER_MAX_GATE_S + 1, &i64millihz));
+
+    siPpsLeft = 0;
+    const uint64_t u64start = time_us_64();
+    HOST_CHECK(-1 == FreqCounterMeasure(&sFC, 10, &i64millihz));
+    HOST_CHECK(time_us_64() - u64start <= FREQCOUNTER_PPS_TIMEOUT_US + TEST_IDLE_US);
+    HOST_CHECK(!TestIsEnabled());
+
+    /* PPS lost during the gate. */
+    TestSetup(7040100.0);
+    siPpsLeft = 5;
+    HOST_CHECK(-1 == FreqCounterMeasure(&sFC, 10, &i64millihz));
+    FreqCounterDeinit(&sFC);
+}
+
+int main(void)
+{
+    TestMeasure();
+    TestErrors();
+
+    return 0;
+}
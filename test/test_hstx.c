@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_hstx.c - Host test of HSTX output of the bitstream engine.
+//
+//  DESCRIPTION
+//      Built for RP2350. The bitstream engine on an HSTX GPIO is to set up the
+//      shifter and the DMA to HSTX FIFO, and to render the tones at twice HSTX
+//      CLK. The words are shifted out by a model of HSTX set up as the registers
+//      say, and the bits are to make the freq of each tone plus its error.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+
+#include <math.h>
+
+#define TEST_FREQ_STEP_MILLIHZ 2930     /* WSPR tone spacing, *2 as WSPR_FREQ_STEP_MILHZ. */
+#define TEST_HSTX_GPIO 12
+
+static PioDco sDCO;
+static uint8_t su8Bits[2 * 32 * PIODCO_PATTERN_MAX_WORDS];
+
+/// @brief Shifts out words as HSTX does with the CSR and BIT registers: each
+/// @brief CLK the register gives the bits of SEL_P and SEL_N of the GPIO on
+/// @brief the two edges and rotates right by SHIFT, a word lasts N_SHIFTS.
+/// @param pu32words Ptr to the words.
+/// @param nwords A count of words.
+/// @return A count of bits.
+static size_t TestHstxShift(const uint32_t *pu32words, size_t nwords)
+{
+    const uint32_t u32csr = hstx_ctrl_hw->csr;
+    const uint32_t u32bit = hstx_ctrl_hw->bit[TEST_HSTX_GPIO - PIODCO_HSTX_FIRST_GPIO];
+    const int shift = (u32csr >> HSTX_CTRL_CSR_SHIFT_LSB) & 31;
+    const int nshifts = (u32csr >> HSTX_CTRL_CSR_N_SHIFTS_LSB) & 31;
+    const int selp = (u32bit >> HSTX_CTRL_BIT0_SEL_P_LSB) & 31;
+    const int seln = (u32bit >> HSTX_CTRL_BIT0_SEL_N_LSB) & 31;
+
+    size_t n = 0;
+    for(size_t i = 0; i < nwords; ++i)
+    {
+        uint32_t u32sr = pu32words[i];
+        for(int c = 0; c < nshifts; ++c)
+        {
+            su8Bits[n++] = (u32sr >> selp) & 1;
+            su8Bits[n++] = (u32sr >> seln) & 1;
+            u32sr = shift ? (u32sr >> shift) | (u32sr << (32 - shift)) : u32sr;
+        }
+    }
+
+    return n;
+}
+
+/// @brief Checks the bits of a tone shifted out.
+/// @param itone Index of the tone.
+/// @param want_hz The freq of tone, Hz.
+static void TestTone(int itone, double want_hz)
+{
+    const size_t n = TestHstxShift(sui32_pattern[itone], sDCO._u16_pattern_len[itone]);
+    HOST_CHECK(32 * sDCO._u16_pattern_len[itone] == n);
+
+    /* The rising edges of a loop, the last one might wrap. */
+    uint32_t p = 0;
+    size_t high = 0;
+    for(size_t k = 0; k < n; ++k)
+    {
+        p += su8Bits[k] && !su8Bits[(k + n - 1) % n];
+        high += su8Bits[k];
+    }
+    HOST_CHECK(p > 0);
+
+    const double frq_hz = 2.0 * gHostClkHstxHz * p / n * sDCO._u8_harmonic_n;
+    HOST_CHECK(fabs(frq_hz - want_hz - 1e-3 * sDCO._i32_pattern_err_millihz[itone]) < 1e-3);
+
+    const double bits_per_cycle = (double)n / p;
+    uint32_t r = 0;
+    for(size_t k = 0; k < n; ++k)
+    {
+        if(su8Bits[k] && !su8Bits[(k + n - 1) % n])
+        {
+            HOST_CHECK(fabs(k - r * bits_per_cycle) < 1.0);
+            ++r;
+        }
+    }
+    HOST_CHECK(fabs((double)high / p - bits_per_cycle / 2) < 1.0);
+}
+
+/// @brief Checks the tones of a WSPR transmission by HSTX.
+/// @param u32frq_hz The freq of tone 0, Hz.
+static void TestHstx(uint32_t u32frq_hz)
+{
+    HostReset();
+    gHostClkSysHz = 200000000;
+    gHostClkHstxHz = 150000000;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, TEST_HSTX_GPIO));
+    PioDCOSetEngine(&sDCO, eDCOENGINE_BITSTREAM);
+    HOST_CHECK(2 * gHostClkHstxHz == sDCO._u32_hstx_bit_hz);
+    PioDCOSetHarmonic(&sDCO, 0);
+    PioDCOSetFreq(&sDCO, u32frq_hz, 0);
+
+    HOST_CHECK(0 == PioDCOPatternInit(&sDCO));
+    HOST_CHECK(HostDmaWriteAddr(sDCO._dma_chan[0]) == &hstx_fifo_hw->fifo);
+    PioDCOHstxInit(&sDCO);
+
+    int32_t i32worst = 0;
+    for(int i = PIODCO_PATTERN_TONES - 1; i >= 0; --i)
+    {
+        HOST_CHECK(0 == PioDCOPatternBuild(&sDCO, i, u32frq_hz, i * TEST_FREQ_STEP_MILLIHZ));
+        TestTone(i, u32frq_hz + 0.5e-3 * i * TEST_FREQ_STEP_MILLIHZ);
+        const int32_t i32err = abs(sDCO._i32_pattern_err_millihz[i]);
+        i32worst = i32err > i32worst ? i32err : i32worst;
+    }
+
+    /* HSTX is started and stopped instead of SM. */
+    HOST_CHECK(!(hstx_ctrl_hw->csr & HSTX_CTRL_CSR_EN_BITS));
+    PioDCOStart(&sDCO);
+    HOST_CHECK(hstx_ctrl_hw->csr & HSTX_CTRL_CSR_EN_BITS);
+    HOST_CHECK(!(sDCO._pio->ctrl & (1U << sDCO._ism)));
+    PioDCOStop(&sDCO);
+    HOST_CHECK(!(hstx_ctrl_hw->csr & HSTX_CTRL_CSR_EN_BITS));
+
+    /* The suspend gives the GPIO back to PIO, for any engine of next run. */
+    hstx_ctrl_hw->csr = HSTX_CTRL_CSR_EN_BITS;
+    PioDCOSuspend(&sDCO);
+    HOST_CHECK(0 == hstx_ctrl_hw->csr);
+
+    printf("%9lu Hz HSTX %3lu MHz N=%d: %4u words, error %8ld mHz, worst tone %8ld mHz\n",
+           (unsigned long)u32frq_hz, (unsigned long)(gHostClkHstxHz / MHZ), sDCO._u8_harmonic_n,
+           sDCO._u16_pattern_len[0], (long)sDCO._i32_pattern_err_millihz[0], (long)i32worst);
+}
+
+int main(void)
+{
+    static const uint32_t au32frq_hz[] = { 137500, 475700, 1838100, 3570100, 7040100, 10140200,
+                                           14097100, 18106100, 21096100, 24926100, 28126100,
+                                           50294500 };
+    for(size_t i = 0; i < sizeof(au32frq_hz) / sizeof(au32frq_hz[0]); ++i)
+    {
+        TestHstx(au32frq_hz[i]);
+    }
+
+    /* Not an HSTX GPIO, PIO it is. */
+    HostReset();
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, eDCOENGINE_BITSTREAM);
+    HOST_CHECK(0 == sDCO._u32_hstx_bit_hz);
+
+    return 0;
+}
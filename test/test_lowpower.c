@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_lowpower.c - Host test of the slot schedule of low power mode.
+//
+//  DESCRIPTION
+//      The beacon is run second by second in virtual time over the hour
+//      boundaries, the symbols being sent by the alarms of TxChannel. The TX is
+//      to start at the second 1 of each TX slot, and WSPRbeaconSecondsToTx is to
+//      count down to it exactly, so the full clock is back LOWPOWER_WAKE_SECS
+//      before each TX. The beacon logs to stdout, the results go to stderr.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "../TxChannel/TxChannel.c"
+#include "../WSPRbeacon/WSPRbeacon.c"
+
+#define TEST_HOURS 3
+#define TEST_MAX_SKIP 9             /* SLOTSKIP of settings. */
+#define TEST_OFFSETS 5
+#define TEST_TX_SECS 111
+
+SettingsData settingsData;
+
+void StampPrintf(const char *pformat, ...)
+{
+}
+
+/// @brief Tells whether a second is the start of TX as the schedule says.
+/// @param t The second.
+/// @param skip The TX slot skip, SLOTSKIP + 1.
+/// @param offset The initial slot offset.
+/// @return Non-zero if it is.
+static int TestIsTxStart(uint32_t t, uint32_t skip, uint32_t offset)
+{
+    const uint32_t isec_of_hour = t % HOUR;
+    return 1 == isec_of_hour % (2 * MINUTE) && 0 == (isec_of_hour / (2 * MINUTE) + offset) % skip;
+}
+
+/// @brief Runs the beacon over the hours.
+/// @param skip The TX slot skip, SLOTSKIP + 1.
+/// @param offset The initial slot offset.
+/// @param t0 The second to start at.
+/// @return The share of seconds in low power.
+static double TestSchedule(uint32_t skip, uint32_t offset, uint32_t t0)
+{
+    static int32_t secs[TEST_HOURS * HOUR];
+    static uint8_t is_start[TEST_HOURS * HOUR];
+
+    HostReset();
+    gHostClkSysHz = 125000000;
+    HostSetTimeUs((uint64_t)t0 * 1000000);
+    memset(&DCO, 0, sizeof(DCO));
+    HOST_CHECK(0 == PioDCOInit(&DCO, 6));
+    memset(&becaconData, 0, sizeof(becaconData));
+    itx_trigger = 0;
+    WSPRbeaconInit("R2BDY", "KO85", 10, 14095600, 1500, 6);
+    becaconData._txSched._u8_tx_slot_skip = skip;
+    becaconData.initialSlotOffset = offset;
+    HOST_CHECK(0 == WSPRbeaconCreatePacket(false));
+
+    uint32_t nlow = 0, ntx = 0, u32tx_start = 0;
+    for(uint32_t i = 0; i < TEST_HOURS * HOUR; ++i)
+    {
+        /* The symbols of the second are sent, then the PPS comes. */
+        const uint32_t t = t0 + i;
+        HostAlarmRunUntil((uint64_t)t * 1000000);
+        becaconData.secondsCounter = t;
+
+        const int itx = itx_trigger;
+        WSPRbeaconTxScheduler(NO);
+        is_start[i] = !itx && itx_trigger;
+        HOST_CHECK(is_start[i] == TestIsTxStart(t, skip, offset));
+        if(is_start[i])
+        {
+            u32tx_start = t;
+            ++ntx;
+        }
+
+        /* 162 symbols of 682667 us end in the 111th second. */
+        if(itx && !itx_trigger)
+        {
+            HOST_CHECK(TEST_TX_SECS == t - u32tx_start);
+        }
+
+        secs[i] = WSPRbeaconSecondsToTx();
+        HOST_CHECK(itx_trigger ? 0 == secs[i] : secs[i] > 0);
+        nlow += secs[i] > LOWPOWER_WAKE_SECS;
+    }
+
+    HOST_CHECK(ntx >= TEST_HOURS * (HOUR / (2 * MINUTE) / skip) - 1);
+
+    /* It counts down to the next start. */
+    int32_t inext = -1;
+    for(int32_t i = TEST_HOURS * HOUR - 1; i >= 0; --i)
+    {
+        if(inext >= 0 && secs[i])
+        {
+            HOST_CHECK(inext - i == secs[i]);
+        }
+        if(is_start[i])
+        {
+            inext = i;
+        }
+    }
+
+    return (double)nlow / (TEST_HOURS * HOUR);
+}
+
+int main(void)
+{
+    /* The beacon logs each TX. */
+    HOST_CHECK(freopen("/dev/null", "w", stdout));
+
+    for(uint32_t skip_setting = 0; skip_setting <= TEST_MAX_SKIP; ++skip_setting)
+    {
+        double low = 0.0;
+        for(uint32_t offset = 0; offset < TEST_OFFSETS; ++offset)
+        {
+            /* It starts 7 minutes before an hour boundary. */
+            low += TestSchedule(skip_setting + 1, offset, 5 * HOUR - 7 * MINUTE + 13 * offset);
+        }
+        fprintf(stderr, "SLOTSKIP %lu: %.1f%% of seconds in low power\n", (unsigned long)skip_setting,
+                100.0 * low / TEST_OFFSETS);
+    }
+
+    return 0;
+}
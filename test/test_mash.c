@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_mash.c - Host test and spur benchmark of MASH engine of DCO.
+//
+//  DESCRIPTION
+//      The words of MASH worker are to stay above zero, within the range of
+//      their order, and to average the cycles of freq. The order is lowered
+//      where even the highest harmonic can't keep the word positive, the
+//      worker switches to it on the next freq. The close-in spurs of the
+//      quantization error are measured for each order.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+
+#include <math.h>
+
+#define TEST_WORDS 8192
+#define TEST_CLOSE_BINS (TEST_WORDS / 64)   /* Close to carrier: below 1/64 of word rate. */
+
+static PioDco sDCO;
+static uint32_t su32SwitchAt;       /* The word the freq is switched at, 0 none. */
+static uint32_t su32SwitchHz;
+
+/// @brief Sets the freq to switch to from the worker, as if core0 did.
+/// @param sm The SM the word is put to.
+/// @param word The word.
+static void TestOnPut(uint sm, uint32_t word)
+{
+    if(su32SwitchAt && HostPioCaptured(sm, NULL) == su32SwitchAt)
+    {
+        PioDCOSetFreq(&sDCO, su32SwitchHz, 0);
+    }
+}
+
+/// @brief Sets up MASH engine at a freq.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param harmonic The harmonic set, 0 is auto.
+/// @param order The order of MASH set.
+/// @param u32frq_hz The freq, Hz.
+static void TestSetup(uint32_t u32clk_hz, int harmonic, int order, uint32_t u32frq_hz)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, eDCOENGINE_MASH);
+    PioDCOSetHarmonic(&sDCO, harmonic);
+    PioDCOSetNoiseShaping(&sDCO, order, NO);
+    PioDCOSetFreq(&sDCO, u32frq_hz, 0);
+}
+
+/// @brief Runs MASH worker for TEST_WORDS words.
+/// @return Ptr to the words.
+static const uint32_t *TestRun(void)
+{
+    const uint32_t *pu32words;
+    HostPioCaptureStop(sDCO._ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorkerMASH(&sDCO);
+    }
+    HOST_CHECK(TEST_WORDS == HostPioCaptured(sDCO._ism, &pu32words));
+
+    return pu32words;
+}
+
+/// @brief Checks the words of an order: above zero, in the range of order,
+/// @brief and the mean being the cycles of freq.
+/// @param pu32words Ptr to the words.
+/// @param n A count of words.
+/// @param pdesc Ptr to the descriptor of freq.
+static void TestCheckWords(const uint32_t *pu32words, int n, const PioDcoFreqDesc *pdesc)
+{
+    const int32_t i32n = pdesc->_i32_precise_cycles >> 24;
+    const int32_t i32span = PIODCO_MASH_SPAN(pdesc->_u8_mash_order);
+    int64_t i64sum = 0;
+    for(int i = 0; i < n; ++i)
+    {
+        const int32_t i32word = (int32_t)pu32words[i];
+        HOST_CHECK(i32word >= 1);
+        HOST_CHECK(i32word >= i32n - i32span + 1 && i32word <= i32n + i32span);
+        i64sum += (int64_t)i32word << 24;
+    }
+
+    /* The accumulators hold less than a word of each order. */
+    const int64_t i64error = i64sum - (int64_t)n * pdesc->_i32_precise_cycles;
+    HOST_CHECK(llabs(i64error) <= 4LL << 24);
+}
+
+/// @brief Measures the strongest close-in spur of the quantization error of
+/// @brief words, dB to a cycle.
+/// @param pu32words Ptr to the words.
+/// @param i32cycles The cycles per word, scaled by 2^24.
+/// @return The spur, dB.
+static double TestCloseSpurDb(const uint32_t *pu32words, int32_t i32cycles)
+{
+    const double ideal = (double)i32cycles / (1 << 24);
+    double max_power = 0.0;
+    for(int k = 1; k < TEST_CLOSE_BINS; ++k)
+    {
+        double re = 0.0, im = 0.0;
+        for(int i = 0; i < TEST_WORDS; ++i)
+        {
+            /* Hann window, the spurs far off don't leak in. */
+            const double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / TEST_WORDS);
+            const double e = w * ((double)pu32words[i] - ideal);
+            re += e * cos(2.0 * M_PI * k * i / TEST_WORDS);
+            im -= e * sin(2.0 * M_PI * k * i / TEST_WORDS);
+        }
+        const double power = (re * re + im * im) / ((double)TEST_WORDS * TEST_WORDS);
+        if(power > max_power)
+        {
+            max_power = power;
+        }
+    }
+
+    return 10.0 * log10(max_power + 1e-30);
+}
+
+/// @brief Checks each order at a freq the auto harmonic fits all of them,
+/// @brief the close-in spur is to go down with the order.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+static void TestOrders(uint32_t u32clk_hz, uint32_t u32frq_hz)
+{
+    double spur_db[4];
+    for(int order = 1; order <= 3; ++order)
+    {
+        TestSetup(u32clk_hz, 0, order, u32frq_hz);
+        const PioDcoFreqDesc *pdesc = &sDCO._freq[sDCO._u32_freq_seq & 1];
+        HOST_CHECK(order == pdesc->_u8_mash_order);
+        HOST_CHECK(order == PioDCOCalcMASHOrder(u32clk_hz, 0, order, u32frq_hz));
+
+        const uint32_t *pu32words = TestRun();
+        HOST_CHECK(order == sDCO._u8_mash_run);
+        TestCheckWords(pu32words, TEST_WORDS, pdesc);
+        spur_db[order] = TestCloseSpurDb(pu32words, pdesc->_i32_precise_cycles);
+
+        printf("%9lu Hz at %3lu MHz MASH %d: harmonic %u, close-in spur %6.1f dB\n",
+               (unsigned long)u32frq_hz, (unsigned long)(u32clk_hz / MHZ), order,
+               sDCO._u8_harmonic_n, spur_db[order]);
+    }
+
+    HOST_CHECK(spur_db[2] < spur_db[1]);
+    HOST_CHECK(spur_db[3] < spur_db[2]);
+}
+
+/// @brief Checks the order is lowered where the harmonic set is too low, and
+/// @brief the word stays above zero.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param harmonic The harmonic set.
+/// @param u32frq_hz The freq, Hz.
+/// @param order_fit The order expected.
+static void TestLowered(uint32_t u32clk_hz, int harmonic, uint32_t u32frq_hz, int order_fit)
+{
+    TestSetup(u32clk_hz, harmonic, 3, u32frq_hz);
+    const PioDcoFreqDesc *pdesc = &sDCO._freq[sDCO._u32_freq_seq & 1];
+    HOST_CHECK(order_fit == pdesc->_u8_mash_order);
+    HOST_CHECK(order_fit == PioDCOCalcMASHOrder(u32clk_hz, harmonic, 3, u32frq_hz));
+
+    const uint32_t *pu32words = TestRun();
+    HOST_CHECK(order_fit == sDCO._u8_mash_run);
+    TestCheckWords(pu32words, TEST_WORDS, pdesc);
+
+    uint32_t u32min = UINT32_MAX, u32max = 0;
+    for(int i = 0; i < TEST_WORDS; ++i)
+    {
+        u32min = pu32words[i] < u32min ? pu32words[i] : u32min;
+        u32max = pu32words[i] > u32max ? pu32words[i] : u32max;
+    }
+    printf("%9lu Hz at %3lu MHz harmonic %d: MASH 3 runs as %d, words %lu..%lu\n",
+           (unsigned long)u32frq_hz, (unsigned long)(u32clk_hz / MHZ), harmonic, order_fit,
+           (unsigned long)u32min, (unsigned long)u32max);
+}
+
+/// @brief Checks the worker switches to the order of a new freq.
+static void TestSwitch(void)
+{
+    TestSetup(200000000, 1, 3, 7040100);
+    HOST_CHECK(3 == sDCO._freq[sDCO._u32_freq_seq & 1]._u8_mash_order);
+
+    su32SwitchAt = TEST_WORDS / 2;
+    su32SwitchHz = 18106100;
+    gHostOnPut = TestOnPut;
+    const uint32_t *pu32words = TestRun();
+    su32SwitchAt = 0;
+
+    const PioDcoFreqDesc *pdesc = &sDCO._freq[sDCO._u32_freq_seq & 1];
+    HOST_CHECK(1 == pdesc->_u8_mash_order);
+    HOST_CHECK(1 == sDCO._u8_mash_run);
+
+    /* The word being made when the freq is published is of the old one. */
+    TestCheckWords(pu32words + TEST_WORDS / 2 + 1, TEST_WORDS / 2 - 1, pdesc);
+    printf("MASH 3 -> %d on switch to %lu Hz\n", sDCO._u8_mash_run, (unsigned long)su32SwitchHz);
+}
+
+int main(void)
+{
+    TestOrders(125000000, 7040100);
+    TestOrders(200000000, 14097100);
+    TestOrders(200000000, 18106100);
+    TestOrders(270000000, 28126100);
+
+    TestLowered(200000000, 1, 18106100, 1);
+    TestLowered(125000000, 3, 28126100, 2);
+    TestLowered(270000000, 1, 24926100, 1);
+    TestSwitch();
+
+    return 0;
+}
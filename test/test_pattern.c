@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_pattern.c - Host test of pattern engine of DCO.
+//
+//  DESCRIPTION
+//      The tone select is to be a single store of the control block pointer:
+//      the DMA chain reloads the count and the address of data channel from
+//      one block, so they always belong to the same tone. The patterns are to
+//      be of the freq of their tones, less the error the engine reports,
+//      which is that of the best rational of PIODCO_PATTERN_MAX_WORDS, on
+//      every WSPR band at every SYSCLK profile.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "../persistentStorage.c"
+
+#include <math.h>
+
+#define TEST_FREQ_STEP_MILLIHZ 2930     /* WSPR tone spacing, *2 as WSPR_FREQ_STEP_MILHZ. */
+#define TEST_WSPR_MIDDLE_HZ 100         /* The middle of WSPR range, WSPR_FREQ_RANGE_HZ / 2. */
+
+int Core1MeasureCarrier(uint32_t u32_frq_hz, int gate_s, int64_t *pi64_millihz, int *pharmonic)
+{
+    return -1;
+}
+
+/// @brief Does what the select and the control DMA channels do when the data
+/// @brief channel has sent a period of pattern, as they are wired.
+/// @param pdco Ptr to DCO context.
+/// @param pu32count Ptr to the count the data channel gets.
+/// @param pu32addr Ptr to the read address the data channel gets.
+static void TestReload(const PioDco *pdco, uint32_t *pu32count, uint32_t *pu32addr)
+{
+    const int idata = pdco->_dma_chan[0], ictrl = pdco->_dma_chan[1], isel = pdco->_dma_chan[2];
+
+    HOST_CHECK(HostDmaReadAddr(isel) == &pdco->_pu32_pattern_ctrl && 1 == HostDmaTransCount(isel));
+    HOST_CHECK(HostDmaWriteAddr(isel) == &dma_hw->ch[ictrl].al3_read_addr_trig);
+    const uint32_t *pu32block = *(const uint32_t * const volatile *)HostDmaReadAddr(isel);
+
+    HOST_CHECK(HostDmaWriteAddr(ictrl) == &dma_hw->ch[idata].al3_transfer_count);
+    HOST_CHECK(2 == HostDmaTransCount(ictrl));
+    HOST_CHECK(&dma_hw->ch[idata].al3_read_addr_trig == &dma_hw->ch[idata].al3_transfer_count + 1);
+
+    /* The write address of control channel is not reloaded, it is to wrap
+       back to the count on the 8 byte ring, which the count starts. */
+    const uint32_t u32ctrl = HostDmaCtrl(ictrl);
+    HOST_CHECK(u32ctrl & DMA_CH0_CTRL_TRIG_INCR_READ_BITS);
+    HOST_CHECK(u32ctrl & DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS);
+    HOST_CHECK(u32ctrl & DMA_CH0_CTRL_TRIG_RING_SEL_BITS);
+    HOST_CHECK(3 == (u32ctrl & DMA_CH0_CTRL_TRIG_RING_SIZE_BITS) >> DMA_CH0_CTRL_TRIG_RING_SIZE_LSB);
+    HOST_CHECK(0 == offsetof(dma_channel_hw_t, al3_transfer_count) % 8);
+
+    /* Data chains to select, which chains to none, i.e. to itself. */
+    HOST_CHECK((uint32_t)isel == (HostDmaCtrl(idata) & DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS)
+                                 >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+    HOST_CHECK((uint32_t)isel == (HostDmaCtrl(isel) & DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS)
+                                 >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+    HOST_CHECK((uint32_t)ictrl == (u32ctrl & DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS)
+                                  >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+    *pu32count = pu32block[0];
+    *pu32addr = pu32block[1];
+}
+
+/// @brief Checks the tone patterns of a WSPR transmission and their selects.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq of tone 0, Hz.
+static void TestPattern(uint32_t u32clk_hz, uint32_t u32frq_hz)
+{
+    static PioDco dco;
+
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    HOST_CHECK(0 == PioDCOInit(&dco, 6));
+    PioDCOSetEngine(&dco, eDCOENGINE_PATTERN);
+    PioDCOSetFreq(&dco, u32frq_hz, 0);
+    HOST_CHECK(0 == PioDCOPatternInit(&dco));
+
+    for(int i = 0; i < PIODCO_PATTERN_TONES; ++i)
+    {
+        const int32_t i32frq_millihz = i * TEST_FREQ_STEP_MILLIHZ;
+        HOST_CHECK(0 == PioDCOPatternBuild(&dco, i, u32frq_hz, i32frq_millihz));
+        HOST_CHECK(PioDCOPatternError(&dco, u32frq_hz, i32frq_millihz) == dco._i32_pattern_err_millihz[i]);
+
+        const uint32_t u32len = dco._u16_pattern_len[i];
+        HOST_CHECK(u32len >= 1 && u32len <= PIODCO_PATTERN_MAX_WORDS);
+
+        /* The pattern is a whole number of PIs of its actual freq, which is
+           that of the tone plus the error reported. */
+        uint64_t u64cycles = 0;
+        for(uint32_t w = 0; w < u32len; ++w)
+        {
+            u64cycles += sui32_pattern[i][w] + PIOASM_DELAY_CYCLES;
+        }
+        /* The PIO CLK is divided on LF. */
+        const double frq_hz = (double)u32clk_hz * dco._u8_harmonic_n * u32len
+                              / (2.0 * u64cycles * dco._u16_clkdiv);
+        const double want_hz = u32frq_hz + 0.5e-3 * i32frq_millihz + 1e-3 * dco._i32_pattern_err_millihz[i];
+        /* Less the 2^-24 cycle the cycles per PI are rounded to. */
+        HOST_CHECK(fabs(frq_hz - want_hz) < want_hz / dco._frq_cycles_per_pi + 1e-3);
+
+        /* The best rational p/q of q <= N is the nearer of the neighbours
+           of the fraction of cycles in the Farey sequence of N, the other
+           one is of denominator N + 1 - q at least, so it is within
+           1/(2*q*(N+1-q)). The error is that relative to the cycles per PI. */
+        const double cycles_per_pi = PioDCOCalcCyclesPerPi(&dco, u32frq_hz, i32frq_millihz) / (double)(1<<24);
+        const double max_err_millihz = 1e3 * u32frq_hz 
+                                       / (cycles_per_pi * 2 * u32len * (PIODCO_PATTERN_MAX_WORDS + 1 - u32len));
+        HOST_CHECK(abs(dco._i32_pattern_err_millihz[i]) <= max_err_millihz + 1.0);
+
+        printf("%9lu Hz at %3lu MHz tone %d: %4lu words %5lu bytes, error %6ld mHz of max %6.0f\n",
+               (unsigned long)u32frq_hz, (unsigned long)(u32clk_hz / MHZ), i, (unsigned long)u32len,
+               (unsigned long)(u32len * sizeof(uint32_t)), (long)dco._i32_pattern_err_millihz[i],
+               max_err_millihz);
+    }
+
+    /* The first select starts the chain, the later ones only swap the block. */
+    HOST_CHECK(!HostDmaStarted(dco._dma_chan[2]));
+    PioDCOPatternSelect(&dco, 0);
+    HOST_CHECK(HostDmaStarted(dco._dma_chan[2]));
+
+    const uint32_t u32count0 = HostDmaTransCount(dco._dma_chan[0]);
+    uint32_t u32rnd = 1;
+    for(int n = 0; n < 1000; ++n)
+    {
+        PRN32(&u32rnd);
+        const int itone = u32rnd % PIODCO_PATTERN_TONES;
+        PioDCOPatternSelect(&dco, itone);
+        HOST_CHECK(u32count0 == HostDmaTransCount(dco._dma_chan[0]));
+
+        uint32_t u32count, u32addr;
+        TestReload(&dco, &u32count, &u32addr);
+        HOST_CHECK(dco._u16_pattern_len[itone] == u32count);
+        HOST_CHECK((uint32_t)(uintptr_t)sui32_pattern[itone] == u32addr);
+    }
+
+    /* The tones out of range, such as key up, leave the pattern as it is. */
+    const uint32_t *pu32ctrl = dco._pu32_pattern_ctrl;
+    const int aibad[] = { -1, PIODCO_PATTERN_TONES, 0xFF };
+    for(size_t n = 0; n < sizeof(aibad) / sizeof(aibad[0]); ++n)
+    {
+        PioDCOPatternSelect(&dco, aibad[n]);
+        HOST_CHECK(pu32ctrl == dco._pu32_pattern_ctrl);
+    }
+
+    /* The patterns are shared, another DCO gets them once they are released. */
+    static PioDco dco2;
+    HOST_CHECK(0 == PioDCOInit(&dco2, 8));
+    PioDCOSetEngine(&dco2, eDCOENGINE_PATTERN);
+    HOST_CHECK(-1 == PioDCOPatternInit(&dco2));
+
+    PioDCOSuspend(&dco);
+    HOST_CHECK(NULL == dco._pu32_pattern_ctrl);
+    for(int i = 0; i < PIODCO_DMA_CHANS; ++i)
+    {
+        HOST_CHECK(dco._dma_chan[i] < 0);
+    }
+
+    HOST_CHECK(0 == PioDCOPatternInit(&dco2));
+    PioDCOSuspend(&dco2);
+}
+
+int main(void)
+{
+    printf("Pattern buffers: %lu bytes, %lu per tone\n", (unsigned long)sizeof(sui32_pattern),
+           (unsigned long)sizeof(sui32_pattern[0]));
+
+    /* The middle of the WSPR range of each band, at each SYSCLK profile. */
+    for(int ic = 0; ic < NUM_SYSCLK_PROFILES; ++ic)
+    {
+        for(int ib = 0; ib < NUM_BANDS; ++ib)
+        {
+            TestPattern(sysClockProfiles[ic] * MHZ, bandFrequencies[ib] + TEST_WSPR_MIDDLE_HZ);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_phase.c - Host test of phase shifts of DCO.
+//
+//  DESCRIPTION
+//      A shift is to delay the on-air carrier by a fraction of its cycle at a
+//      word boundary, the freq staying the same, on dco and dco16 u-programs and
+//      in harmonic mode. The engines which ignore shifts are to refuse them.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "hostdco.h"
+
+#define TEST_WORDS 8192
+#define TEST_SHIFT_WORD (TEST_WORDS / 2)
+#define TEST_SETTLE_WORDS 16        /* The words skipped around the shift. */
+
+static PioDco sDCO;
+static uint64_t su64Edges[4 * TEST_WORDS];
+static int32_t si32Shift;
+
+/// @brief Shifts the phase from the worker, as if core0 did.
+/// @param sm The SM the word is put to.
+/// @param word The word.
+static void TestOnPut(uint sm, uint32_t word)
+{
+    if(TEST_SHIFT_WORD == HostPioCaptured(sm, NULL))
+    {
+        HOST_CHECK(0 == PioDCOPhaseShift(&sDCO, si32Shift));
+    }
+}
+
+/// @brief Measures the mean delay of edges against the ideal ones.
+/// @param pu64edges Ptr to the edge times, cycles.
+/// @param first The first edge.
+/// @param last The edge after the last one.
+/// @param cycles_per_pi The cycles per PI of the freq.
+/// @return The delay, cycles.
+static double TestMeanDelay(const uint64_t *pu64edges, size_t first, size_t last, double cycles_per_pi)
+{
+    double sum = 0.0;
+    for(size_t k = first; k < last; ++k)
+    {
+        sum += (double)pu64edges[k] - (k + 1) * cycles_per_pi;
+    }
+
+    return sum / (last - first);
+}
+
+/// @brief Shifts the phase of CPU worker V.2 halfway and measures it.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+/// @param harmonic The harmonic.
+/// @param i32shift The shift, 1/1000 of on-air cycle.
+/// @param tolerance The error allowed, 1/1000 of on-air cycle.
+static void TestShift(uint32_t u32clk_hz, uint32_t u32frq_hz, int harmonic, int32_t i32shift,
+                      double tolerance)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, eDCOENGINE_CPU);
+    PioDCOSetHarmonic(&sDCO, harmonic);
+    PioDCOSetFreq(&sDCO, u32frq_hz, 0);
+    HOST_CHECK(harmonic == sDCO._u8_harmonic_n);
+    gHostOnPut = TestOnPut;
+    si32Shift = i32shift;
+
+    const uint32_t *pu32words;
+    HostPioCaptureStop(sDCO._ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorker2(&sDCO);
+    }
+    HOST_CHECK(TEST_WORDS == HostPioCaptured(sDCO._ism, &pu32words));
+
+    const int dco16 = eDCOPROG_DCO16 == sDCO._program;
+    const size_t per_word = dco16 ? 2 : 4;
+    const size_t n = dco16 ? HostDco16Edges(pu32words, TEST_WORDS, su64Edges)
+                           : HostDcoEdges(pu32words, TEST_WORDS, su64Edges);
+    const double cycles_per_pi = (double)sDCO._frq_cycles_per_pi / (1 << 24);
+
+    const double before = TestMeanDelay(su64Edges, per_word * TEST_SETTLE_WORDS,
+                                        per_word * (TEST_SHIFT_WORD - TEST_SETTLE_WORDS), cycles_per_pi);
+    const double after = TestMeanDelay(su64Edges, per_word * (TEST_SHIFT_WORD + TEST_SETTLE_WORDS),
+                                       n, cycles_per_pi);
+
+    /* The fundamental is delayed by 1/N of the on-air shift. */
+    const double got = fmod((after - before) / (2.0 * cycles_per_pi) * harmonic * 1000.0 + 1000.0, 1000.0);
+    const double want = (i32shift % 1000 + 1000) % 1000;
+    double err = got - want;
+    err -= 1000.0 * floor(err / 1000.0 + 0.5);
+    HOST_CHECK(fabs(err) < tolerance);
+
+    printf("%9lu Hz N=%d %-5s shift %4ld -> %8.3f mcyc, error %+.3f\n", (unsigned long)u32frq_hz,
+           harmonic, dco16 ? "dco16" : "dco", (long)i32shift, got, err);
+}
+
+/// @brief Checks the engines which ignore shifts refuse them.
+static void TestRefused(void)
+{
+    HostReset();
+    gHostClkSysHz = 125000000;
+    memset(&sDCO, 0, sizeof(sDCO));
+    HOST_CHECK(0 == PioDCOInit(&sDCO, 6));
+    PioDCOSetEngine(&sDCO, eDCOENGINE_MASH);
+    PioDCOSetFreq(&sDCO, 7040100, 0);
+    HOST_CHECK(-1 == PioDCOPhaseShift(&sDCO, 500));
+    HOST_CHECK(0 == sDCO._i32_phase_total);
+
+    /* A whole cycle is no shift. */
+    PioDCOSetEngine(&sDCO, eDCOENGINE_CPU);
+    PioDCOSetFreq(&sDCO, 7040100, 0);
+    HOST_CHECK(0 == PioDCOPhaseShift(&sDCO, -2000));
+    HOST_CHECK(0 == sDCO._i32_phase_total);
+}
+
+int main(void)
+{
+    TestShift(200000000, 7040100, 1, 500, 1.0);
+    TestShift(200000000, 7040100, 1, 250, 1.0);
+    TestShift(200000000, 7040100, 1, 1, 1.0);
+    TestShift(200000000, 7040100, 1, -250, 1.0);
+    TestShift(125000000, 14097100, 1, 500, 1.0);
+    TestShift(200000000, 1838100, 1, 500, 1.0);
+    TestShift(200000000, 3570100, 1, 250, 1.0);
+    TestShift(200000000, 28126100, 3, 500, 5.0);
+    TestShift(200000000, 50294500, 5, 250, 5.0);
+
+    TestRefused();
+
+    return 0;
+}
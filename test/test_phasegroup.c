@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_phasegroup.c - Host test of multi-phase group of DCOs.
+//
+//  DESCRIPTION
+//      PioDCOWorkerPhased is run as it is, the words stored to the TXF of each SM
+//      of the group are captured. The SMs are to get the same words but the first
+//      one, stretched by the phase delay, so the rising edges of each output are
+//      the delay after those of the first. The delay is to be within 3/4 PIO CLK
+//      cycle of the offset set; tones and GPS nudges are not to resync the group,
+//      a band change is. The cycles per PI are checked against 128-bit maths.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "hostdco.h"
+
+#define TEST_WORDS 8192
+#define TEST_FREQ_STEP_MILLIHZ 2930     /* WSPR tone spacing, *2 as WSPR_FREQ_STEP_MILHZ. */
+
+static PioDco sDCO[PIODCO_MAX_OUTPUTS];
+static PioDco *spGroup[PIODCO_MAX_OUTPUTS];
+static uint64_t su64Edges[PIODCO_MAX_OUTPUTS][4 * TEST_WORDS];
+static uint32_t su32FrqHz;
+static uint32_t su32BandHz;         /* The band changed to halfway, 0 none. */
+
+/// @brief Makes the edges of the words put by a sync: the first one is the x
+/// @brief of the first half-period, the second one the y of the other three,
+/// @brief then a word gives 4 half-periods as HostDcoEdges.
+/// @param pu32words Ptr to the words of the sync.
+/// @param nwords A count of words.
+/// @param pu64edges Ptr to 4 * nwords - 4 edge times, cycles.
+/// @return A count of edges, the rising ones are odd.
+static size_t TestSyncEdges(const uint32_t *pu32words, size_t nwords, uint64_t *pu64edges)
+{
+    pu64edges[0] = pu32words[0] + PIOASM_DELAY_CYCLES;
+    for(int h = 1; h < 4; ++h)
+    {
+        pu64edges[h] = pu64edges[h - 1] + pu32words[1] + PIOASM_DELAY_CYCLES;
+    }
+    const size_t n = 4 + HostDcoEdges(&pu32words[2], nwords - 2, &pu64edges[4]);
+    for(size_t i = 4; i < n; ++i)
+    {
+        pu64edges[i] += pu64edges[3];
+    }
+
+    return n;
+}
+
+/// @brief Changes the freq from the worker, as core0 does, and lets the SMs
+/// @brief run with no stall: the host flags are plain memory, not W1C.
+/// @param sm The SM the word is put to.
+/// @param word The word.
+static void TestOnPut(uint sm, uint32_t word)
+{
+    pio0->fdebug = 0;
+    if(sm != sDCO[0]._ism)
+    {
+        return;
+    }
+
+    switch(HostPioCaptured(sm, NULL))
+    {
+        case 1000: PioDCOSetFreq(&sDCO[0], su32FrqHz, 1 * TEST_FREQ_STEP_MILLIHZ); break;
+        case 2000: PioDCOSetFreq(&sDCO[0], su32FrqHz, 3 * TEST_FREQ_STEP_MILLIHZ); break;
+        case 3000: PioDCOSetFreq(&sDCO[0], su32FrqHz, 2 * TEST_FREQ_STEP_MILLIHZ); break;
+        case 3500: PioDCOSetFreq(&sDCO[0], su32FrqHz, 2 * TEST_FREQ_STEP_MILLIHZ + 7); break;
+        case TEST_WORDS / 2:
+            if(su32BandHz)
+            {
+                PioDCOSetFreq(&sDCO[0], su32BandHz, 0);
+            }
+            break;
+    }
+}
+
+/// @brief Runs a phase group, the outputs 250 mc apart, with the tones of
+/// @brief WSPR and a nudge, and maybe a band change halfway.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32frq_hz The freq, Hz.
+/// @param n A count of outputs.
+/// @param u32band_hz The band changed to halfway, 0 none.
+/// @return The worst error of output phase, mc, in the second half.
+static double TestGroup(uint32_t u32clk_hz, uint32_t u32frq_hz, int n, uint32_t u32band_hz)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    memset(sDCO, 0, sizeof(sDCO));
+    for(int i = 0; i < n; ++i)
+    {
+        HOST_CHECK(0 == PioDCOInit(&sDCO[i], 6 + i));
+        spGroup[i] = &sDCO[i];
+    }
+    PioDCOSetEngine(&sDCO[0], eDCOENGINE_CPU);
+    HOST_CHECK(0 == PioDCOPhaseGroupInit(spGroup, n));
+    for(int i = 1; i < n; ++i)
+    {
+        PioDCOSetPhaseOffset(spGroup[i], i * 250);
+    }
+    PioDCOSetFreq(&sDCO[0], u32frq_hz, 0);
+    PioDCOStart(&sDCO[0]);
+    su32FrqHz = u32frq_hz;
+    su32BandHz = u32band_hz;
+    gHostOnPut = TestOnPut;
+
+    HostPioCaptureStop(sDCO[0]._ism, TEST_WORDS);
+    if(!setjmp(gHostStop))
+    {
+        PioDCOWorkerPhased(spGroup, n);
+    }
+    HOST_CHECK((u32band_hz ? 2U : 1U) == HostPioSyncs());
+
+    /* The words after a sync start with the stretched one. */
+    const uint32_t *apu32words[PIODCO_MAX_OUTPUTS];
+    size_t nwords = TEST_WORDS, first = 0;
+    for(int i = 0; i < n; ++i)
+    {
+        const size_t ncaptured = HostPioCaptured(sDCO[i]._ism, &apu32words[i]);
+        nwords = ncaptured < nwords ? ncaptured : nwords;
+    }
+    if(u32band_hz)
+    {
+        first = TEST_WORDS / 2;
+        while(apu32words[n - 1][first] == apu32words[0][first])
+        {
+            ++first;
+        }
+    }
+    for(int i = 0; i < n; ++i)
+    {
+        HOST_CHECK(apu32words[i][first] - apu32words[0][first] == sDCO[i]._u32_phase_delay);
+        HOST_CHECK(!memcmp(&apu32words[i][first + 1], &apu32words[0][first + 1],
+                           (nwords - first - 1) * sizeof(uint32_t)));
+        TestSyncEdges(&apu32words[i][first], nwords - first, su64Edges[i]);
+    }
+
+    /* The rising edges of each output are its delay after the first one. */
+    const double cycles_per_pi = (double)sDCO[0]._frq_cycles_per_pi / (1 << 24);
+    const double bound = 0.75 * 1000.0 * sDCO[0]._u8_harmonic_n / (2.0 * cycles_per_pi);
+    double worst = 0.0;
+    for(int i = 1; i < n; ++i)
+    {
+        for(size_t k = 1; k < 4 * (nwords - first - 1); k += 2)
+        {
+            HOST_CHECK(su64Edges[i][k] - su64Edges[0][k] == sDCO[i]._u32_phase_delay);
+        }
+        const double offset = sDCO[i]._u32_phase_delay * 1000.0 * sDCO[0]._u8_harmonic_n
+                              / (2.0 * cycles_per_pi);
+        double err = fmod(offset, 1000.0) - i * 250;
+        err -= 1000.0 * floor(err / 1000.0 + 0.5);
+        HOST_CHECK(fabs(err) <= bound);
+        HOST_CHECK(abs(PioDCOGetPhaseOffset(spGroup[i]) - (int32_t)floor(fmod(offset, 1000.0) + 0.5)) <= 1);
+        worst = fabs(err) > worst ? fabs(err) : worst;
+    }
+
+    printf("%9lu Hz at %3lu MHz N=%d, %d outputs: worst %6.2f mc, bound %6.2f mc\n",
+           (unsigned long)(u32band_hz ? u32band_hz : u32frq_hz), (unsigned long)(u32clk_hz / MHZ),
+           sDCO[0]._u8_harmonic_n, n, worst, bound);
+
+    return worst;
+}
+
+/// @brief Checks PioDCOCalcCyclesPerPi64 against 128-bit maths, the harmonics
+/// @brief at the fastest CLK are where the numerator exceeds 63 bits.
+static void TestCyclesPerPi(void)
+{
+    static const uint32_t au32frq_hz[] = { 137500, 475700, 1838100, 3570100, 7040100, 10140200,
+                                           14097100, 18106100, 21096100, 24926100, 28126100,
+                                           50294500 };
+    int nchecked = 0;
+    for(uint32_t u32clk_hz = 125000000; u32clk_hz <= 270000000; u32clk_hz += 5000000)
+    {
+        for(uint32_t n = 1; n <= PIODCO_MAX_HARMONIC; n += 2)
+        {
+            for(size_t i = 0; i < sizeof(au32frq_hz) / sizeof(au32frq_hz[0]); ++i)
+            {
+                for(int32_t m = -TEST_FREQ_STEP_MILLIHZ; m <= 3 * TEST_FREQ_STEP_MILLIHZ; m += 977)
+                {
+                    const __int128 den = 2000 * (__int128)au32frq_hz[i] + m;
+                    const __int128 num = ((__int128)u32clk_hz * n * 1000) << 24;
+                    const int64_t i64want = (int64_t)((2 * num + den) / (2 * den));
+                    HOST_CHECK(i64want == PioDCOCalcCyclesPerPi64(u32clk_hz, n, au32frq_hz[i], m));
+                    ++nchecked;
+                }
+            }
+        }
+    }
+    printf("Cycles per PI: %d of CLK, harmonic and freq exact\n", nchecked);
+}
+
+int main(void)
+{
+    static const uint32_t au32frq_hz[] = { 1838100, 7040100, 14097100, 21096100, 28126100 };
+    for(size_t i = 0; i < sizeof(au32frq_hz) / sizeof(au32frq_hz[0]); ++i)
+    {
+        TestGroup(200000000, au32frq_hz[i], 2, 0);
+        TestGroup(200000000, au32frq_hz[i], 4, 0);
+    }
+
+    /* A band change syncs once more. */
+    TestGroup(200000000, 7040100, 4, 14097100);
+
+    TestCyclesPerPi();
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_spscring.c - Host stress test of SPSC ring.
+//
+//  DESCRIPTION
+//      A producer thread and a consumer thread pass elements of {tone,
+//      duration_us, phase_step, seq} through a short ring as fast as they can,
+//      the indexes started close to the 2^32 wrap. The consumer alternates Pop
+//      and Peek/Drop. No element is to be lost, duplicated or torn. It is worth
+//      running under -fsanitize=thread too.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include <pthread.h>
+#include <sched.h>
+#include "hostsdk.h"
+#include "../pico-hf-oscillator/lib/spscring.h"
+
+#define TEST_ELEMENTS 2000000U
+#define TEST_RING_LEN 16
+
+typedef struct
+{
+    uint8_t _u8_tone;
+    uint32_t _u32_duration_us;
+    int32_t _i32_phase_step;
+    uint32_t _u32_seq;
+} TestElement;
+
+SPSC_RING_DEFINE(TestRing, TestElement, TEST_RING_LEN)
+
+static TestRing sRing;
+static uint32_t su32Full;           /* Pushes refused, the producer only. */
+static uint32_t su32Empty;          /* Pops refused, the consumer only. */
+
+/// @brief Makes the element of a seq, every field of its own.
+/// @param u32seq The seq.
+/// @return The element.
+static TestElement TestMake(uint32_t u32seq)
+{
+    const TestElement e = { (uint8_t)u32seq, u32seq * 3U, -(int32_t)u32seq, u32seq };
+    return e;
+}
+
+/// @brief Checks an element is the one of a seq.
+/// @param pe Ptr to the element.
+/// @param u32seq The seq.
+/// @return Non-zero if so.
+static int TestIsOf(const TestElement *pe, uint32_t u32seq)
+{
+    const TestElement e = TestMake(u32seq);
+    return pe->_u32_seq == e._u32_seq && pe->_u8_tone == e._u8_tone
+        && pe->_u32_duration_us == e._u32_duration_us && pe->_i32_phase_step == e._i32_phase_step;
+}
+
+/// @brief Pushes the elements in order of seq, yielding when the ring is full.
+/// @param parg Unused.
+/// @return NULL.
+static void *TestProducer(void *parg)
+{
+    (void)parg;
+    for(uint32_t i = 0; i < TEST_ELEMENTS;)
+    {
+        const TestElement e = TestMake(i);
+        if(TestRingPush(&sRing, &e))
+        {
+            ++i;
+        }
+        else
+        {
+            ++su32Full;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/// @brief Takes the elements by Pop and by Peek/Drop in turn, and checks them.
+/// @param parg Ptr to a count of bad elements.
+/// @return NULL.
+static void *TestConsumer(void *parg)
+{
+    uint32_t *pu32bad = parg;
+    for(uint32_t i = 0; i < TEST_ELEMENTS;)
+    {
+        TestElement e;
+        if(i & 1)
+        {
+            const TestElement *pe = TestRingPeek(&sRing);
+            if(!pe)
+            {
+                ++su32Empty;
+                sched_yield();
+                continue;
+            }
+            e = *pe;
+            TestRingDrop(&sRing);
+        }
+        else if(!TestRingPop(&sRing, &e))
+        {
+            ++su32Empty;
+            sched_yield();
+            continue;
+        }
+        *pu32bad += !TestIsOf(&e, i++);
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    /* The bounds first: a full ring refuses, an empty one too. */
+    TestRingClear(&sRing);
+    TestElement e = TestMake(0);
+    for(uint32_t i = 0; i < TEST_RING_LEN; ++i)
+    {
+        HOST_CHECK(TestRingPush(&sRing, &e));
+    }
+    HOST_CHECK(!TestRingPush(&sRing, &e));
+    HOST_CHECK(TEST_RING_LEN == TestRingCount(&sRing));
+    TestRingDropAll(&sRing);
+    HOST_CHECK(0 == TestRingCount(&sRing));
+    HOST_CHECK(!TestRingPop(&sRing, &e));
+    HOST_CHECK(NULL == TestRingPeek(&sRing));
+
+    /* Wrap the indexes early. */
+    sRing._u32_head = sRing._u32_tail = 0xFFFFFFF0U;
+
+    uint32_t u32bad = 0;
+    pthread_t producer, consumer;
+    HOST_CHECK(0 == pthread_create(&producer, NULL, TestProducer, NULL));
+    HOST_CHECK(0 == pthread_create(&consumer, NULL, TestConsumer, &u32bad));
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    printf("%u elements through %d deep ring, %u bad, %u pushes full, %u pops empty\n",
+           TEST_ELEMENTS, TEST_RING_LEN, u32bad, su32Full, su32Empty);
+    HOST_CHECK(0 == u32bad);
+    HOST_CHECK(0 == TestRingCount(&sRing));
+
+    return 0;
+}
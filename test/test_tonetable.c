@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_tonetable.c - Host test of tone table of DCO.
+//
+//  DESCRIPTION
+//      The tone table is made by core0 thread code while the worker runs on the
+//      freq published last, so building it is not to touch DCO: its harmonic,
+//      PIO CLK divider and published freq stay until a tone is selected, which
+//      applies the ones of the tone.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+
+#define TEST_FREQ_STEP_MILLIHZ 2930     /* WSPR tone spacing, *2 as WSPR_FREQ_STEP_MILHZ. */
+
+/// @brief Builds a tone table of another band than DCO runs on and selects
+/// @brief its tones.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32run_hz The freq DCO runs on, Hz.
+/// @param u32tx_hz The freq of tone 0 of the table, Hz.
+static void TestToneTable(uint32_t u32clk_hz, uint32_t u32run_hz, uint32_t u32tx_hz)
+{
+    static PioDco dco;
+    static PioDcoToneTable tt;
+
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    HOST_CHECK(0 == PioDCOInit(&dco, 6));
+    PioDCOSetFreq(&dco, u32run_hz, 0);
+
+    const uint8_t u8harmonic = dco._u8_harmonic_n;
+    const uint16_t u16clkdiv = dco._u16_clkdiv;
+    const uint32_t u32smdiv = dco._pio->sm[dco._ism].clkdiv;
+    const uint32_t u32seq = dco._u32_freq_seq;
+    const int32_t i32cycles = dco._frq_cycles_per_pi;
+    HOST_CHECK(u32smdiv == (uint32_t)u16clkdiv << 16);
+
+    PioDCOToneTableBuild(&dco, &tt, u32tx_hz, TEST_FREQ_STEP_MILLIHZ);
+    HOST_CHECK(u8harmonic == dco._u8_harmonic_n);
+    HOST_CHECK(u16clkdiv == dco._u16_clkdiv);
+    HOST_CHECK(u32smdiv == dco._pio->sm[dco._ism].clkdiv);
+    HOST_CHECK(u32seq == dco._u32_freq_seq);
+    HOST_CHECK(i32cycles == dco._frq_cycles_per_pi);
+    HOST_CHECK(u32run_hz == dco._ui32_frq_hz);
+
+    /* A tone is the same as setting its freq, without divisions. */
+    PioDco ref = dco;
+    for(int i = PIODCO_TONE_TABLE_LEN - 1; i >= 0; --i)
+    {
+        PioDCOToneSelect(&dco, &tt, i);
+        PioDCOSetFreq(&ref, u32tx_hz, i * TEST_FREQ_STEP_MILLIHZ);
+        HOST_CHECK(dco._u8_harmonic_n == ref._u8_harmonic_n);
+        HOST_CHECK(dco._u16_clkdiv == ref._u16_clkdiv);
+        HOST_CHECK(dco._pio->sm[dco._ism].clkdiv == (uint32_t)ref._u16_clkdiv << 16);
+        HOST_CHECK(dco._frq_cycles_per_pi == ref._frq_cycles_per_pi);
+        HOST_CHECK(dco._freq[dco._u32_freq_seq & 1]._i32_precise_cycles
+                   == ref._freq[ref._u32_freq_seq & 1]._i32_precise_cycles);
+    }
+
+    printf("%9lu Hz -> %9lu Hz at %3lu MHz: harmonic %u -> %u, clkdiv %u -> %u\n",
+           (unsigned long)u32run_hz, (unsigned long)u32tx_hz, (unsigned long)(u32clk_hz / MHZ),
+           u8harmonic, dco._u8_harmonic_n, u16clkdiv, dco._u16_clkdiv);
+}
+
+int main(void)
+{
+    TestToneTable(125000000, 14097100, 475700);
+    TestToneTable(125000000, 475700, 14097100);
+    TestToneTable(125000000, 7040100, 50294400);
+    TestToneTable(200000000, 50294400, 137500);
+
+    return 0;
+}
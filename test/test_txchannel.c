@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  test_txchannel.c - Host test of TxChannel on timed queue of DCO.
+//
+//  DESCRIPTION
+//      A transmission is queued to the timed queue as far as it fits, the
+//      symbols left in the channel or pushed later are sent by the symbol ISR
+//      from the end of the queued part, so none is lost. The carrier starts
+//      on the tone of the 1st symbol.
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "../pico-hf-oscillator/piodco/piodco.c"
+#include "../TxChannel/TxChannel.c"
+
+#define TEST_SYMBOLS (PIODCO_TIMED_QUEUE_LEN + 44)
+_Static_assert(TXCHANNEL_RING_LEN >= PIODCO_TIMED_QUEUE_LEN, "The 1st push is to fill the timed queue");
+#define TEST_SYMBOL_US 683000
+
+/// @brief Sends a transmission longer than the timed queue, the part which
+/// @brief doesn't fit is pushed while the queued one is being sent.
+static void TestTimedOverflow(void)
+{
+    static TxChannelSymbol sym[TEST_SYMBOLS];
+
+    HostReset();
+    gHostClkSysHz = 125000000;
+    HostSetTimeUs(1000000);
+    HOST_CHECK(0 == PioDCOInit(&DCO, 6));
+    PioDCOSetEngine(&DCO, eDCOENGINE_TIMED);
+    TxChannelInit(TEST_SYMBOL_US, 0);
+    TxChannelSetFrequency(14095600, 0);
+
+    uint32_t u32rnd = 1;
+    for(int i = 0; i < TEST_SYMBOLS; ++i)
+    {
+        PRN32(&u32rnd);
+        sym[i]._u8_tone = i ? u32rnd & 3 : 2;
+        sym[i]._u32_duration_us = TEST_SYMBOL_US;
+    }
+    HOST_CHECK(PIODCO_TIMED_QUEUE_LEN == TxChannelPushSymbols(sym, PIODCO_TIMED_QUEUE_LEN));
+
+    TxChannelStart();
+    HOST_CHECK(TEST_SYMBOLS - PIODCO_TIMED_QUEUE_LEN 
+               == TxChannelPushSymbols(sym + PIODCO_TIMED_QUEUE_LEN, TEST_SYMBOLS - PIODCO_TIMED_QUEUE_LEN));
+
+    /* The carrier is on the 1st tone from the start. */
+    HOST_CHECK(DCO._is_enabled);
+    PioDcoFreqDesc desc;
+    PioDCOGetFreqDesc(&DCO, &desc);
+    HOST_CHECK(desc._i32_frq_millihz == txChannelContext._p_tones->_desc[sym[0]._u8_tone]._i32_frq_millihz);
+    HOST_CHECK(desc._i32_precise_cycles == txChannelContext._p_tones->_desc[sym[0]._u8_tone]._i32_precise_cycles);
+
+    /* The queue is full, the rest is in the channel. */
+    HOST_CHECK(PIODCO_TIMED_QUEUE_LEN == PioDcoTimedRingCount(&DCO._timed));
+    HOST_CHECK(TEST_SYMBOLS - PIODCO_TIMED_QUEUE_LEN == TxChannelPending());
+    for(int i = 0; i < PIODCO_TIMED_QUEUE_LEN; ++i)
+    {
+        const PioDcoTimedCmd *pcmd = &DCO._timed._elem[i];
+        HOST_CHECK(1000000 + 10000 + (uint64_t)i * TEST_SYMBOL_US == pcmd->_u64_time_us);
+        HOST_CHECK(PioDCOCalcCyclesPerPi(&DCO, txChannelContext._u32_Txfreqhz, 
+                                         sym[i]._u8_tone * WSPR_FREQ_STEP_MILHZ)
+                   - (PIOASM_DELAY_CYCLES<<24) == pcmd->_i32_precise_cycles);
+    }
+
+    /* ISR takes over where the queued part ends. */
+    for(int i = PIODCO_TIMED_QUEUE_LEN; i < TEST_SYMBOLS; ++i)
+    {
+        HOST_CHECK(HostAlarmRunNext());
+        HOST_CHECK(1000000 + 10000 + (uint64_t)i * TEST_SYMBOL_US == time_us_64());
+        HOST_CHECK(TxChannelIsRunning());
+        PioDCOGetFreqDesc(&DCO, &desc);
+        HOST_CHECK(desc._i32_frq_millihz == txChannelContext._p_tones->_desc[sym[i]._u8_tone]._i32_frq_millihz);
+    }
+    HOST_CHECK(0 == TxChannelPending());
+
+    HOST_CHECK(HostAlarmRunNext());
+    HOST_CHECK(1000000 + 10000 + (uint64_t)TEST_SYMBOLS * TEST_SYMBOL_US == time_us_64());
+    HOST_CHECK(!TxChannelIsRunning());
+    HOST_CHECK(!DCO._is_enabled);
+    HOST_CHECK(!HostAlarmRunNext());
+
+    printf("%d symbols: %d timed, %d by ISR, none lost\n", TEST_SYMBOLS, PIODCO_TIMED_QUEUE_LEN,
+           TEST_SYMBOLS - PIODCO_TIMED_QUEUE_LEN);
+}
+
+/// @brief Checks the shift of the tone patterns: within the WSPR range, and
+/// @brief the spacing error of the patterns built is the one reported.
+/// @param u32clk_hz The system CLK, Hz.
+/// @param u32dial_hz The dial freq, Hz.
+/// @param i32offset_hz The offset of TX within the range, Hz.
+/// @param fit Whether a shift is to fit TXCHANNEL_PATTERN_MAX_ERR_MILLIHZ.
+static void TestPatternShift(uint32_t u32clk_hz, uint32_t u32dial_hz, int32_t i32offset_hz, int fit)
+{
+    HostReset();
+    gHostClkSysHz = u32clk_hz;
+    HOST_CHECK(0 == PioDCOInit(&DCO, 6));
+    PioDCOSetEngine(&DCO, eDCOENGINE_PATTERN);
+    TxChannelInit(TEST_SYMBOL_US, 0);
+    TxChannelSetFrequency(u32dial_hz, (uint32_t)i32offset_hz);
+    HOST_CHECK(0 == PioDCOPatternInit(&DCO));
+
+    TxChannelBuildTonePatterns();
+
+    const int32_t i32shift = txChannelContext._i32_pattern_shift_hz;
+    const uint32_t u32frq_hz = txChannelContext._u32_Txfreqhz + i32shift;
+    HOST_CHECK(u32frq_hz >= u32dial_hz && u32frq_hz + 6 <= u32dial_hz + WSPR_FREQ_RANGE_HZ);
+
+    int32_t i32worst = 0;
+    for(int i = 1; i < PIODCO_PATTERN_TONES; ++i)
+    {
+        const int32_t i32err = DCO._i32_pattern_err_millihz[i] - DCO._i32_pattern_err_millihz[0];
+        if(abs(i32err) > i32worst)
+        {
+            i32worst = abs(i32err);
+        }
+    }
+    HOST_CHECK(i32worst == txChannelContext._i32_pattern_err_millihz);
+    HOST_CHECK(fit == (i32worst <= TXCHANNEL_PATTERN_MAX_ERR_MILLIHZ));
+
+    /* The shift found is the smallest one fitting, none of the smaller ones
+       within the range fits. */
+    for(int32_t d = -abs(i32shift) + 1; fit && d < abs(i32shift); ++d)
+    {
+        const uint32_t u32d_hz = txChannelContext._u32_Txfreqhz + d;
+        HOST_CHECK(u32d_hz < u32dial_hz || u32d_hz + 6 > u32dial_hz + WSPR_FREQ_RANGE_HZ
+                   || TxChannelPatternSpacingError(u32d_hz, 0) > TXCHANNEL_PATTERN_MAX_ERR_MILLIHZ);
+    }
+
+    printf("%9lu Hz %+4ld at %3lu MHz: shift %+4ld Hz, spacing error %4ld mHz\n", (unsigned long)u32dial_hz,
+           (long)i32offset_hz, (unsigned long)(u32clk_hz / MHZ), (long)i32shift, (long)i32worst);
+}
+
+/// @brief Stops the channel which has never been started, so it has no tone
+/// @brief table yet; the freq is to be left as it is.
+static void TestStopUnstarted(void)
+{
+    HostReset();
+    memset(&txChannelContext, 0, sizeof(txChannelContext));
+    HOST_CHECK(0 == PioDCOInit(&DCO, 6));
+    TxChannelInit(TEST_SYMBOL_US, 0);
+    TxChannelSetFrequency(14095600, 0);
+    PioDcoFreqDesc desc0, desc;
+    PioDCOGetFreqDesc(&DCO, &desc0);
+
+    TxChannelStop();
+    HOST_CHECK(NULL == txChannelContext._p_tones);
+    HOST_CHECK(!TxChannelIsRunning());
+    PioDCOGetFreqDesc(&DCO, &desc);
+    HOST_CHECK(0 == memcmp(&desc0, &desc, sizeof(desc)));
+}
+
+int main(void)
+{
+    TestStopUnstarted();
+    TestTimedOverflow();
+    TestPatternShift(125000000, 7040000, 0, YES);
+    TestPatternShift(200000000, 14097000, 0, YES);
+    TestPatternShift(200000000, 14097000, 90, YES);
+    TestPatternShift(200000000, 14097000, -90, YES);
+    TestPatternShift(270000000, 18106000, 0, YES);
+    TestPatternShift(200000000, 28126000, 0, NO);
+
+    return 0;
+}